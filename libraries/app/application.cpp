@@ -269,6 +269,8 @@ namespace detail {
          if( _options->count("check-locks") )
             _chain_db->set_require_locking( true );
 
+         _chain_db->set_thread_pool_size( _options->at("chain-threads").as<uint32_t>() );
+
          if( _options->count("shared-file-dir") )
             _shared_dir = fc::path( _options->at("shared-file-dir").as<string>() );
          else
@@ -287,6 +289,14 @@ namespace detail {
                _chain_db->wipe(_data_dir / "blockchain", _shared_dir, true);
 
             _chain_db->set_flush_interval( _options->at("flush").as<uint32_t>() );
+            _chain_db->set_invariant_audit_interval( _options->at("invariant-audit-interval").as<uint32_t>() );
+            _chain_db->set_deferred_notification_blocks( _options->at("replay-deferred-notification-blocks").as<uint32_t>() );
+            _chain_db->set_max_unlinked_blocks( _options->at("max-unlinked-blocks").as<uint32_t>() );
+            _chain_db->get_transaction_pool().set_limits(
+               _options->at("max-pending-transactions").as<uint32_t>(),
+               _options->at("max-pending-transaction-bytes").as<uint64_t>(),
+               _options->at("max-pending-transactions-per-account").as<uint32_t>() );
+            _chain_db->get_block_timer().set_slow_threshold( fc::milliseconds( _options->at("slow-block-threshold-ms").as<uint32_t>() ) );
 
             flat_map<uint32_t,block_id_type> loaded_checkpoints;
             if( _options->count("checkpoint") )
@@ -304,7 +314,7 @@ namespace detail {
             if( _options->count("replay-blockchain") )
             {
                ilog("Replaying blockchain on user request.");
-               _chain_db->reindex( _data_dir / "blockchain", _shared_dir, _shared_file_size );
+               _chain_db->reindex( _data_dir / "blockchain", _shared_dir, _shared_file_size, _options->at("replay-checkpoint-interval").as<uint32_t>() );
             }
             else
             {
@@ -318,7 +328,7 @@ namespace detail {
 
                   try
                   {
-                     _chain_db->reindex( _data_dir / "blockchain", _shared_dir, _shared_file_size );
+                     _chain_db->reindex( _data_dir / "blockchain", _shared_dir, _shared_file_size, _options->at("replay-checkpoint-interval").as<uint32_t>() );
                   }
                   catch( chain::block_log_exception& )
                   {
@@ -864,8 +874,8 @@ namespace detail {
       { try {
          return _chain_db->with_read_lock( [&]()
          {
-            auto opt_block = _chain_db->fetch_block_by_id( block_id );
-            if( opt_block.valid() ) return opt_block->timestamp;
+            auto block = _chain_db->fetch_shared_block_by_id( block_id );
+            if( block ) return block->timestamp;
             return fc::time_point_sec::min();
          });
       } FC_CAPTURE_AND_RETHROW( (block_id) ) }
@@ -993,6 +1003,16 @@ void application::set_program_options(boost::program_options::options_descriptio
          ("enable-plugin", bpo::value< vector<string> >()->composing()->default_value(default_plugins, str_default_plugins), "Plugin(s) to enable, may be specified multiple times")
          ("max-block-age", bpo::value< int32_t >()->default_value(200), "Maximum age of head block when broadcasting tx via API")
          ("flush", bpo::value< uint32_t >()->default_value(100000), "Flush shared memory file to disk this many blocks")
+         ("replay-deferred-notification-blocks", bpo::value< uint32_t >()->default_value(0), "During replay, buffer plugin history indexing and run it in parallel batches of this many blocks (0 to disable)")
+         ("invariant-audit-interval", bpo::value< uint32_t >()->default_value(0), "Check full database invariants every this many blocks and log failures (0 to disable)")
+         ("max-pending-transactions", bpo::value< uint32_t >()->default_value(10000), "Maximum number of pending transactions accepted before new ones are rejected")
+         ("max-pending-transaction-bytes", bpo::value< uint64_t >()->default_value(64*1024*1024), "Maximum total size in bytes of pending transactions")
+         ("max-pending-transactions-per-account", bpo::value< uint32_t >()->default_value(1000), "Maximum number of pending transactions requiring the authority of a single account")
+         ("slow-block-threshold-ms", bpo::value< uint32_t >()->default_value(500), "Log a per stage timing breakdown of blocks that take longer than this many milliseconds to apply")
+         ("max-unlinked-blocks", bpo::value< uint32_t >()->default_value(node::chain::fork_database::MAX_BLOCK_REORDERING), "Maximum number of blocks received ahead of their parent that are buffered until it arrives (0 to disable)")
+         ("chain-threads", bpo::value< uint32_t >()->default_value(2), "Number of worker threads used by the chain database for parallel work")
+         ("replay-checkpoint-interval", bpo::value< uint32_t >()->default_value(0), "Checkpoint replay state this many blocks so an interrupted replay can resume (0 to disable). "
+            "The undo history of each interval is kept in shared memory, so large intervals need a larger shared-file-size")
          ("backtrace", bpo::value<string>()->default_value("yes"), "Whether to print backtrace on SIGSEGV")
          ;
    command_line_options.add(configuration_file_options);
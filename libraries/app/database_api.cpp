@@ -185,9 +185,9 @@ optional<block_header> database_api::get_block_header(uint32_t block_num)const
 
 optional<block_header> database_api_impl::get_block_header(uint32_t block_num) const
 {
-   auto result = _db.fetch_block_by_number(block_num);
+   auto result = _db.fetch_shared_block_by_number(block_num);
    if(result)
-      return *result;
+      return block_header( *result );
    return {};
 }
 
@@ -203,7 +203,10 @@ optional<signed_block_api_obj> database_api::get_block(uint32_t block_num)const
 
 optional<signed_block_api_obj> database_api_impl::get_block(uint32_t block_num)const
 {
-   return _db.fetch_block_by_number(block_num);
+   auto result = _db.fetch_shared_block_by_number(block_num);
+   if(result)
+      return signed_block_api_obj( *result );
+   return {};
 }
 
 vector<applied_operation> database_api::get_ops_in_block(uint32_t block_num, bool only_virtual)const
@@ -2371,8 +2374,8 @@ annotated_signed_transaction database_api::get_transaction( transaction_id_type
       const auto& idx = my->_db.get_index<operation_index>().indices().get<by_transaction_id>();
       auto itr = idx.lower_bound( id );
       if( itr != idx.end() && itr->trx_id == id ) {
-         auto blk = my->_db.fetch_block_by_number( itr->block );
-         FC_ASSERT( blk.valid() );
+         auto blk = my->_db.fetch_shared_block_by_number( itr->block );
+         FC_ASSERT( blk );
          FC_ASSERT( blk->transactions.size() > itr->trx_in_block );
          annotated_signed_transaction result = blk->transactions[itr->trx_in_block];
          result.block_num       = itr->block;
@@ -1,7 +1,10 @@
 #include <node/chain/block_log.hpp>
 #include <fstream>
+#include <mutex>
 #include <fc/io/raw.hpp>
 
+#include <boost/filesystem.hpp>
+
 #define LOG_READ  (std::ios::in | std::ios::binary)
 #define LOG_WRITE (std::ios::out | std::ios::binary | std::ios::app)
 
@@ -18,6 +21,15 @@ namespace node { namespace chain {
             fc::path                 index_file;
             bool                     block_write = false;
             bool                     index_write = false;
+            /// Sizes and head of the files as of the last successful flush
+            uint64_t                 flushed_block_size = 0;
+            uint64_t                 flushed_index_size = 0;
+            optional< signed_block > flushed_head;
+            block_id_type            flushed_head_id;
+            /// Set when unflushed appends could not be discarded, the files may end in a partial block
+            bool                     failed = false;
+            /// Serializes the writer thread's appends with reads from other threads
+            std::recursive_mutex     mutex;
 
             inline void check_block_read()
             {
@@ -170,6 +182,8 @@ namespace node { namespace chain {
          my->index_stream.open( my->index_file.generic_string().c_str(), LOG_WRITE );
          my->index_write = true;
       }
+
+      flush();
    }
 
    void block_log::close()
@@ -186,6 +200,8 @@ namespace node { namespace chain {
    {
       try
       {
+         std::lock_guard< std::recursive_mutex > lock( my->mutex );
+         FC_ASSERT( !my->failed, "Block log could not recover from a failed write and must be repaired before appending." );
          my->check_block_write();
          my->check_index_write();
 
@@ -206,14 +222,54 @@ namespace node { namespace chain {
 
    void block_log::flush()
    {
+      std::lock_guard< std::recursive_mutex > lock( my->mutex );
       my->block_stream.flush();
       my->index_stream.flush();
+
+      if( my->block_file.generic_string().empty() )
+         return;
+
+      my->flushed_block_size = fc::file_size( my->block_file );
+      my->flushed_index_size = fc::file_size( my->index_file );
+      my->flushed_head = my->head;
+      my->flushed_head_id = my->head_id;
+   }
+
+   void block_log::discard_unflushed()
+   {
+      std::lock_guard< std::recursive_mutex > lock( my->mutex );
+
+      // Closing may flush part of the buffered data or fail outright, either way the files are cut back below
+      try { my->block_stream.close(); } catch( ... ) {}
+      try { my->index_stream.close(); } catch( ... ) {}
+      my->block_stream.clear();
+      my->index_stream.clear();
+
+      try
+      {
+         boost::filesystem::resize_file( my->block_file.generic_string(), my->flushed_block_size );
+         boost::filesystem::resize_file( my->index_file.generic_string(), my->flushed_index_size );
+
+         my->block_stream.open( my->block_file.generic_string().c_str(), LOG_WRITE );
+         my->index_stream.open( my->index_file.generic_string().c_str(), LOG_WRITE );
+         my->block_write = true;
+         my->index_write = true;
+         my->head = my->flushed_head;
+         my->head_id = my->flushed_head_id;
+      }
+      catch( const std::exception& e )
+      {
+         my->failed = true;
+         elog( "Unable to discard unflushed blocks from ${f}, the block log is no longer usable: ${e}",
+            ("f", my->block_file)("e", e.what()) );
+      }
    }
 
    std::pair< signed_block, uint64_t > block_log::read_block( uint64_t pos )const
    {
       try
       {
+         std::lock_guard< std::recursive_mutex > lock( my->mutex );
          my->check_block_read();
 
          my->block_stream.seekg( pos );
@@ -229,6 +285,7 @@ namespace node { namespace chain {
    {
       try
       {
+      std::lock_guard< std::recursive_mutex > lock( my->mutex );
       optional< signed_block > b;
       uint64_t pos = get_block_pos( block_num );
       if( pos != npos )
@@ -245,6 +302,7 @@ namespace node { namespace chain {
    {
       try
       {
+         std::lock_guard< std::recursive_mutex > lock( my->mutex );
          my->check_index_read();
 
          if( !( my->head.valid() && block_num <= protocol::block_header::num_from_id( my->head_id ) && block_num > 0 ) )
@@ -261,6 +319,7 @@ namespace node { namespace chain {
    {
       try
       {
+         std::lock_guard< std::recursive_mutex > lock( my->mutex );
          my->check_block_read();
 
          uint64_t pos;
@@ -271,11 +330,24 @@ namespace node { namespace chain {
       FC_LOG_AND_RETHROW()
    }
 
-   const optional< signed_block >& block_log::head()const
+   optional< signed_block > block_log::head()const
    {
+      std::lock_guard< std::recursive_mutex > lock( my->mutex );
       return my->head;
    }
 
+   uint32_t block_log::head_num()const
+   {
+      std::lock_guard< std::recursive_mutex > lock( my->mutex );
+      return my->head.valid() ? protocol::block_header::num_from_id( my->head_id ) : 0;
+   }
+
+   block_id_type block_log::head_id()const
+   {
+      std::lock_guard< std::recursive_mutex > lock( my->mutex );
+      return my->head_id;
+   }
+
    void block_log::construct_index()
    {
       try
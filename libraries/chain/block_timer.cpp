@@ -0,0 +1,181 @@
+#include <node/chain/block_timer.hpp>
+
+#include <node/protocol/operations.hpp>
+#include <node/protocol/operation_util_impl.hpp>
+
+#include <algorithm>
+
+namespace node { namespace chain {
+
+namespace detail {
+
+   // Stages and operation types listed in a slow block report
+   const size_t report_size = 5;
+
+   std::string operation_name( uint32_t which )
+   {
+      std::string name;
+      node::protocol::operation op;
+      op.set_which( which );
+      op.visit( fc::get_operation_name( name ) );
+      return name;
+   }
+
+   fc::microseconds percentile( std::vector< int64_t >& samples, uint32_t p )
+   {
+      auto itr = samples.begin() + ( samples.size() - 1 ) * p / 100;
+      std::nth_element( samples.begin(), itr, samples.end() );
+      return fc::microseconds( *itr );
+   }
+
+} // detail
+
+block_timer::block_timer( size_t window, fc::microseconds slow_threshold )
+   : _max_window( window ), _slow_threshold( slow_threshold )
+{
+   _current.fill( 0 );
+}
+
+const char* block_timer::stage_name( stage_type stage )
+{
+   static const char* names[] = { "prepare", "merkle", "header", "transactions", "global_properties", "irreversible",
+      "expirations", "witness_schedule", "feeds", "funds", "conversions", "comment_cashout", "SCORE_withdrawals",
+      "savings_withdraws", "liquidity_reward", "account_deadlines", "hardforks", "notify", "invariants", "flush" };
+   static_assert( sizeof( names ) / sizeof( names[0] ) == stage_count, "Missing block stage name" );
+   return names[ stage ];
+}
+
+void block_timer::start_block( uint32_t block_num )
+{
+   _in_block = true;
+   _block_num = block_num;
+   _current.fill( 0 );
+   for( auto& op : _operations )
+      op = std::make_pair( 0, 0 );
+   _block_start = fc::time_point::now();
+   _last_mark = _block_start;
+}
+
+void block_timer::record_operation( int64_t which, fc::microseconds elapsed )
+{
+   if( !_in_block )
+      return;
+
+   if( size_t( which ) >= _operations.size() )
+      _operations.resize( which + 1, std::make_pair( 0, 0 ) );
+
+   ++_operations[ which ].first;
+   _operations[ which ].second += elapsed.count();
+}
+
+fc::optional< block_timer::block_report > block_timer::finish_block( uint32_t transactions )
+{
+   fc::optional< block_report > report;
+   if( !_in_block )
+      return report;
+   _in_block = false;
+
+   block_sample sample;
+   sample.total = ( _last_mark - _block_start ).count();
+   sample.stages = _current;
+
+   std::lock_guard< std::mutex > lock( _mutex );
+
+   _window.push_back( sample );
+   while( _window.size() > _max_window )
+      _window.pop_front();
+
+   if( sample.total <= _slow_threshold.count() )
+      return report;
+
+   report = block_report();
+   report->block_num = _block_num;
+   report->transactions = transactions;
+   report->total = fc::microseconds( sample.total );
+
+   std::vector< uint32_t > order;
+   for( uint32_t i = 0; i < stage_count; i++ )
+      if( _current[i] > 0 )
+         order.push_back( i );
+   std::sort( order.begin(), order.end(), [&]( uint32_t a, uint32_t b ){ return _current[a] > _current[b]; } );
+   for( size_t i = 0; i < order.size() && i < detail::report_size; i++ )
+   {
+      stage_time s;
+      s.stage = stage_name( stage_type( order[i] ) );
+      s.elapsed = fc::microseconds( _current[ order[i] ] );
+      report->stages.push_back( s );
+   }
+
+   order.clear();
+   for( uint32_t i = 0; i < _operations.size(); i++ )
+      if( _operations[i].first > 0 )
+         order.push_back( i );
+   std::sort( order.begin(), order.end(), [&]( uint32_t a, uint32_t b ){ return _operations[a].second > _operations[b].second; } );
+   for( size_t i = 0; i < order.size() && i < detail::report_size; i++ )
+   {
+      operation_time o;
+      o.operation = detail::operation_name( order[i] );
+      o.count = _operations[ order[i] ].first;
+      o.elapsed = fc::microseconds( _operations[ order[i] ].second );
+      report->operations.push_back( o );
+   }
+
+   ++_slow_blocks;
+   _last_slow_block = report;
+   return report;
+}
+
+void block_timer::set_slow_threshold( fc::microseconds slow_threshold )
+{
+   std::lock_guard< std::mutex > lock( _mutex );
+   _slow_threshold = slow_threshold;
+}
+
+void block_timer::set_window( size_t window )
+{
+   std::lock_guard< std::mutex > lock( _mutex );
+   _max_window = window;
+   while( _window.size() > _max_window )
+      _window.pop_front();
+}
+
+block_timer::timing_stats block_timer::get_stats()const
+{
+   std::lock_guard< std::mutex > lock( _mutex );
+
+   timing_stats stats;
+   stats.blocks = _window.size();
+   stats.slow_blocks = _slow_blocks;
+   stats.slow_threshold = _slow_threshold;
+   stats.last_slow_block = _last_slow_block;
+
+   if( _window.empty() )
+      return stats;
+
+   std::vector< int64_t > samples;
+   samples.reserve( _window.size() );
+
+   // Index stage_count stands for the whole block
+   for( uint32_t s = 0; s <= stage_count; s++ )
+   {
+      samples.clear();
+      for( const auto& b : _window )
+         samples.push_back( s == stage_count ? b.total : b.stages[s] );
+
+      stage_percentiles p;
+      p.stage = s == stage_count ? "block" : stage_name( stage_type( s ) );
+      p.p50 = detail::percentile( samples, 50 );
+      p.p90 = detail::percentile( samples, 90 );
+      p.p99 = detail::percentile( samples, 99 );
+      p.max = fc::microseconds( *std::max_element( samples.begin(), samples.end() ) );
+
+      if( s == stage_count )
+         stats.stages.insert( stats.stages.begin(), p );
+      else
+         stats.stages.push_back( p );
+   }
+
+   return stats;
+}
+
+} } // node::chain
@@ -28,11 +28,16 @@
 #include <fc/container/deque.hpp>
 
 #include <fc/io/fstream.hpp>
+#include <fc/io/json.hpp>
 
+#include <chrono>
 #include <cstdint>
 #include <deque>
 #include <fstream>
 #include <functional>
+#include <future>
+#include <map>
+#include <mutex>
 
 namespace node { namespace chain {
 
@@ -58,11 +63,18 @@ struct db_schema
    std::vector< operation_schema_repr > custom_operation_types;
 };
 
+struct reindex_checkpoint
+{
+   uint32_t       block_num = 0;
+   block_id_type  block_id;
+};
+
 } }
 
 FC_REFLECT( node::chain::object_schema_repr, (space_type)(type) )
 FC_REFLECT( node::chain::operation_schema_repr, (id)(type) )
 FC_REFLECT( node::chain::db_schema, (types)(object_types)(operation_type)(custom_operation_types) )
+FC_REFLECT( node::chain::reindex_checkpoint, (block_num)(block_id) )
 
 namespace node { namespace chain {
 
@@ -88,11 +100,39 @@ database_impl::database_impl( database& self )
    : _self(self), _evaluator_registry(self) {}
 
 database::database()
-   : _my( new database_impl(*this) ) {}
+   : _my( new database_impl(*this) )
+{
+   static const char* deadline_names[] = { "transactions", "orders", "delegations", "conversions", "comment_cashout",
+      "SCORE_withdrawals", "savings_withdraws", "account_recovery", "escrow_ratification", "decline_voting_rights" };
+   static_assert( sizeof( deadline_names ) / sizeof( deadline_names[0] ) == deadline_category_count, "Missing deadline category name" );
+
+   _deadline_timings.resize( deadline_category_count );
+   for( size_t i = 0; i < _deadline_timings.size(); ++i )
+      _deadline_timings[i].category = deadline_names[i];
+
+   _pre_apply_operation_handlers.resize( operation::count() );
+   _post_apply_operation_handlers.resize( operation::count() );
+}
 
 database::~database()
 {
    clear_pending();
+
+   // close() normally drains the writer, this covers a database destroyed without it
+   try
+   {
+      flush_block_log();
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Failed to flush the block log on shutdown: ${e}", ("e", e.to_detail_string()) );
+   }
+
+   if( _block_log_thread )
+   {
+      _block_log_thread->quit();
+      _block_log_thread.reset();
+   }
 }
 
 void database::open( const fc::path& data_dir, const fc::path& shared_mem_dir, uint64_t initial_supply, uint64_t shared_file_size, uint32_t chainbase_flags )
@@ -102,7 +142,19 @@ void database::open( const fc::path& data_dir, const fc::path& shared_mem_dir, u
       init_schema();
       chainbase::database::open( shared_mem_dir, chainbase_flags, shared_file_size );
 
-      initialize_indexes();
+      // Operation notifications are only ever deferred for the duration of a reindex
+      _defer_operation_notifications = false;
+      _deferred_operation_notifications.clear();
+
+      try
+      {
+         initialize_indexes();
+      }
+      catch( const chainbase::layout_mismatch_error& e )
+      {
+         // chainbase refuses an index whose object layout differs from the one stored in the file
+         FC_ASSERT( false, "Shared memory was created with a different object layout, a replay is required: ${e}", ("e", e.what()) );
+      }
       initialize_evaluators();
 
       if( chainbase_flags & chainbase::database::read_write )
@@ -115,7 +167,10 @@ void database::open( const fc::path& data_dir, const fc::path& shared_mem_dir, u
 
          _block_log.open( data_dir / "block_log" );
 
-         auto log_head = _block_log.head();
+         _block_log_queued_num = _block_log.head_num();
+         _block_log_durable_num = _block_log_queued_num;
+         if( !_block_log_thread )
+            _block_log_thread = std::make_shared< fc::thread >( "block_log" );
 
          // Rewind all undo state. This should return us to the state at the last irreversible block.
          with_write_lock( [&]()
@@ -132,7 +187,7 @@ void database::open( const fc::path& data_dir, const fc::path& shared_mem_dir, u
             // This assertion should be caught and a reindex should occur
             FC_ASSERT( head_block.valid() && head_block->id() == head_block_id(), "Chain state does not match block log. Please reindex blockchain." );
 
-            _fork_db.start_block( *head_block );
+            _fork_db.start_block( std::make_shared< const signed_block >( std::move( *head_block ) ) );
          }
       }
 
@@ -144,17 +199,48 @@ void database::open( const fc::path& data_dir, const fc::path& shared_mem_dir, u
    FC_CAPTURE_LOG_AND_RETHROW( (data_dir)(shared_mem_dir)(shared_file_size) )
 }
 
-void database::reindex( const fc::path& data_dir, const fc::path& shared_mem_dir, uint64_t shared_file_size )
+void database::reindex( const fc::path& data_dir, const fc::path& shared_mem_dir, uint64_t shared_file_size, uint32_t checkpoint_interval )
 {
    try
    {
       ilog( "Reindexing Blockchain" );
-      wipe( data_dir, shared_mem_dir, false );
-      open( data_dir, shared_mem_dir, 0, shared_file_size, chainbase::database::read_write );
+
+      const fc::path checkpoint_file = shared_mem_dir / "reindex_checkpoint.json";
+      bool resumed = false;
+
+      if( checkpoint_interval && fc::exists( checkpoint_file ) )
+      {
+         try
+         {
+            auto cp = fc::json::from_file( checkpoint_file ).as< reindex_checkpoint >();
+
+            // open() rewinds the undo state of the interrupted interval and checks the head block against the block log
+            open( data_dir, shared_mem_dir, 0, shared_file_size, chainbase::database::read_write );
+            FC_ASSERT( head_block_num() == cp.block_num && head_block_id() == cp.block_id,
+               "Chain state does not match reindex checkpoint",
+               ("head_block_num", head_block_num())("head_block_id", head_block_id())("checkpoint", cp) );
+
+            resumed = true;
+            ilog( "Resuming reindex from checkpoint at block ${b}", ("b", cp.block_num) );
+         }
+         catch( const fc::exception& e )
+         {
+            wlog( "Unable to resume reindex from checkpoint, replaying from genesis: ${e}", ("e", e.to_detail_string()) );
+         }
+      }
+
+      if( !resumed )
+      {
+         wipe( data_dir, shared_mem_dir, false );
+         if( fc::exists( checkpoint_file ) )
+            fc::remove( checkpoint_file );
+         open( data_dir, shared_mem_dir, 0, shared_file_size, chainbase::database::read_write );
+      }
+
       _fork_db.reset();    // override effect of _fork_db.start_block() call in open()
 
       auto start = fc::time_point::now();
-      ASSERT( _block_log.head(), block_log_exception, "No blocks in block log. Cannot reindex an empty chain." );
+      ASSERT( _block_log.head_num(), block_log_exception, "No blocks in block log. Cannot reindex an empty chain." );
 
       ilog( "Replaying blocks..." );
 
@@ -169,34 +255,98 @@ void database::reindex( const fc::path& data_dir, const fc::path& shared_mem_dir
          skip_authority_check |
          skip_validate | /// no need to validate operations
          skip_validate_invariants |
+         skip_undo_block |
          skip_block_log;
 
+      _defer_operation_notifications = _deferred_notification_blocks != 0;
+
       with_write_lock( [&]()
       {
-         auto itr = _block_log.read_block( 0 );
-         auto last_block_num = _block_log.head()->block_num();
+         auto last_block_num = _block_log.head_num();
+
+         /**
+          * When checkpointing, each interval is applied inside a single undo session that lives in the
+          * shared memory file. If the process dies mid-interval, open() will undo back to the last checkpoint.
+          */
+         optional< chainbase::database::session > checkpoint_session;
+
+         if( head_block_num() < last_block_num )
+         {
+            auto itr = _block_log.read_block( _block_log.get_block_pos( head_block_num() + 1 ) );
+
+            while( true )
+            {
+               auto cur_block_num = itr.first.block_num();
+               if( cur_block_num % 100000 == 0 )
+                  std::cerr << "   " << double( cur_block_num * 100 ) / last_block_num << "%   " << cur_block_num << " of " << last_block_num <<
+                  "   (" << (get_free_memory() / (1024*1024)) << "M free)\n";
+
+               if( checkpoint_interval && !checkpoint_session.valid() )
+               {
+                  set_revision( head_block_num() );
+                  checkpoint_session = start_undo_session( true );
+               }
+
+               apply_block( itr.first, skip_flags );
+
+               if( _defer_operation_notifications && cur_block_num % _deferred_notification_blocks == 0 )
+                  flush_deferred_operation_notifications();
+
+               if( checkpoint_interval && cur_block_num % checkpoint_interval == 0 && cur_block_num != last_block_num )
+               {
+                  flush_deferred_operation_notifications();
+                  checkpoint_session->push();
+                  checkpoint_session.reset();
+                  commit( revision() );
+                  set_revision( head_block_num() );
+                  chainbase::database::flush();
+
+                  reindex_checkpoint cp;
+                  cp.block_num = head_block_num();
+                  cp.block_id = head_block_id();
+
+                  fc::path tmp_file = checkpoint_file;
+                  tmp_file.replace_extension( ".tmp" );
+                  fc::json::save_to_file( cp, tmp_file );
+                  fc::rename( tmp_file, checkpoint_file );
+
+                  ilog( "Reindex checkpoint at block ${b}", ("b", cp.block_num) );
+               }
 
-         while( itr.first.block_num() != last_block_num )
+               if( cur_block_num == last_block_num )
+                  break;
+
+               itr = _block_log.read_block( itr.second );
+            }
+         }
+
+         flush_deferred_operation_notifications();
+         _defer_operation_notifications = false;
+
+         if( checkpoint_session.valid() )
          {
-            auto cur_block_num = itr.first.block_num();
-            if( cur_block_num % 100000 == 0 )
-               std::cerr << "   " << double( cur_block_num * 100 ) / last_block_num << "%   " << cur_block_num << " of " << last_block_num <<
-               "   (" << (get_free_memory() / (1024*1024)) << "M free)\n";
-            apply_block( itr.first, skip_flags );
-            itr = _block_log.read_block( itr.second );
+            checkpoint_session->push();
+            checkpoint_session.reset();
+            commit( revision() );
          }
 
-         apply_block( itr.first, skip_flags );
          set_revision( head_block_num() );
       });
 
-      if( _block_log.head()->block_num() )
-         _fork_db.start_block( *_block_log.head() );
+      if( fc::exists( checkpoint_file ) )
+         fc::remove( checkpoint_file );
+
+      auto log_head = _block_log.head();
+      if( log_head )
+         _fork_db.start_block( std::make_shared< const signed_block >( std::move( *log_head ) ) );
 
       auto end = fc::time_point::now();
       ilog( "Done reindexing, elapsed time: ${t} sec", ("t",double((end-start).count())/1000000.0 ) );
+
+      for( const auto& s : _operation_profiler.get_stats() )
+         ilog( "Replay evaluator profile: ${s}", ("s", s) );
    }
-   FC_CAPTURE_AND_RETHROW( (data_dir)(shared_mem_dir) )
+   FC_CAPTURE_AND_RETHROW( (data_dir)(shared_mem_dir)(checkpoint_interval) )
 
 }
 
@@ -220,6 +370,17 @@ void database::close(bool rewind)
       // DB state (issue #336).
       clear_pending();
 
+      flush_block_log();
+
+      // Every irreversible block is on disk now, so the undo history kept for blocks in flight can go
+      if( _block_log.is_open() && !( get_node_properties().skip_flags & skip_undo_block ) )
+      {
+         with_write_lock( [&]()
+         {
+            commit( std::min< uint32_t >( get_dynamic_global_properties().last_irreversible_block_num, _block_log_durable_num ) );
+         });
+      }
+
       chainbase::database::flush();
       chainbase::database::close();
 
@@ -232,7 +393,7 @@ void database::close(bool rewind)
 
 bool database::is_known_block( const block_id_type& id )const
 { try {
-   return fetch_block_by_id( id ).valid();
+   return bool( fetch_shared_block_by_id( id ) );
 } FC_CAPTURE_AND_RETHROW() }
 
 /**
@@ -288,32 +449,47 @@ block_id_type database::get_block_id_for_num( uint32_t block_num )const
 
 optional<signed_block> database::fetch_block_by_id( const block_id_type& id )const
 { try {
-   auto b = _fork_db.fetch_block( id );
-   if( !b )
-   {
-      auto tmp = _block_log.read_block_by_num( protocol::block_header::num_from_id( id ) );
+   optional< signed_block > result;
+   auto b = fetch_shared_block_by_id( id );
+   if( b )
+      result = *b;
+   return result;
+} FC_CAPTURE_AND_RETHROW() }
 
-      if( tmp && tmp->id() == id )
-         return tmp;
+optional<signed_block> database::fetch_block_by_number( uint32_t block_num )const
+{ try {
+   optional< signed_block > result;
+   auto b = fetch_shared_block_by_number( block_num );
+   if( b )
+      result = *b;
+   return result;
+} FC_LOG_AND_RETHROW() }
 
-      tmp.reset();
-      return tmp;
-   }
+signed_block_ptr database::fetch_shared_block_by_id( const block_id_type& id )const
+{ try {
+   auto b = _fork_db.fetch_block( id );
+   if( b )
+      return b->data;
 
-   return b->data;
+   auto tmp = _block_log.read_block_by_num( protocol::block_header::num_from_id( id ) );
+   if( tmp && tmp->id() == id )
+      return std::make_shared< const signed_block >( std::move( *tmp ) );
+
+   return signed_block_ptr();
 } FC_CAPTURE_AND_RETHROW() }
 
-optional<signed_block> database::fetch_block_by_number( uint32_t block_num )const
+signed_block_ptr database::fetch_shared_block_by_number( uint32_t block_num )const
 { try {
-   optional< signed_block > b;
+   // Irreversible blocks still being written are only in the fork database, alongside any orphaned siblings
+   auto b = _fork_db.fetch_block_on_main_branch_by_number( block_num );
+   if( b )
+      return b->data;
 
-   auto results = _fork_db.fetch_block_by_number( block_num );
-   if( results.size() == 1 )
-      b = results[0]->data;
-   else
-      b = _block_log.read_block_by_num( block_num );
+   auto tmp = _block_log.read_block_by_num( block_num );
+   if( tmp )
+      return std::make_shared< const signed_block >( std::move( *tmp ) );
 
-   return b;
+   return signed_block_ptr();
 } FC_LOG_AND_RETHROW() }
 
 const signed_transaction database::get_recent_transaction( const transaction_id_type& trx_id ) const
@@ -502,18 +678,40 @@ bool database::before_last_checkpoint()const
  */
 bool database::push_block(const signed_block& new_block, uint32_t skip)
 {
+   return push_block( std::make_shared< const signed_block >( new_block ), skip );
+}
+
+bool database::push_block(const signed_block_ptr& new_block_ptr, uint32_t skip)
+{
+   const signed_block& new_block = *new_block_ptr;
+
    //fc::time_point begin_time = fc::time_point::now();
 
+   // Serialization, hashing and key recovery only depend on the block itself, so they are done before taking the write lock
+   auto prepared = prepare_transactions( new_block, skip );
+
    bool result;
    detail::with_skip_flags( *this, skip, [&]()
    {
       with_write_lock( [&]()
       {
-         detail::without_pending_transactions( *this, std::move(_pending_tx), [&]()
+         _prepared_block_id = new_block.id();
+         _prepared_block_transactions = std::move( prepared );
+
+         detail::without_pending_transactions( *this, _pending_tx.take_all(), [&]()
          {
             try
             {
-               result = _push_block(new_block);
+               try
+               {
+                  result = _push_block(new_block_ptr);
+               }
+               catch( ... )
+               {
+                  // The failed block's undo session may have rolled back hardforks it applied
+                  update_hardfork_cache();
+                  throw;
+               }
             }
             FC_CAPTURE_AND_RETHROW( (new_block) )
          });
@@ -535,7 +733,7 @@ void database::_maybe_warn_multiple_production( uint32_t height )const
       vector< std::pair< account_name_type, fc::time_point_sec > > witness_time_pairs;
       for( const auto& b : blocks )
       {
-         witness_time_pairs.push_back( std::make_pair( b->data.witness, b->data.timestamp ) );
+         witness_time_pairs.push_back( std::make_pair( b->data->witness, b->data->timestamp ) );
       }
 
       ilog( "Encountered block num collision at block ${n} due to a fork, witnesses are: ${w}", ("n", height)("w", witness_time_pairs) );
@@ -543,40 +741,88 @@ void database::_maybe_warn_multiple_production( uint32_t height )const
    return;
 }
 
-bool database::_push_block(const signed_block& new_block)
+bool database::_push_block(const signed_block_ptr& new_block_ptr)
 { try {
+   const signed_block& new_block = *new_block_ptr;
+   const block_id_type new_block_id = new_block.id();
    uint32_t skip = get_node_properties().skip_flags;
    //uint32_t skip_undo_db = skip & skip_undo_block;
 
    if( !(skip&skip_fork_db) )
    {
-      shared_ptr<fork_item> new_head = _fork_db.push_block(new_block);
+      shared_ptr<fork_item> new_head = _fork_db.push_block(new_block_ptr);
       _maybe_warn_multiple_production( new_head->num );
 
       //If the head block from the longest chain does not build off of the current head, we need to switch forks.
-      if( new_head->data.previous != head_block_id() )
+      if( new_head->previous_id() != head_block_id() )
       {
          //If the newly pushed block is the same height as head, we get head back in new_head
          //Only switch forks if new_head is actually higher than head
-         if( new_head->data.block_num() > head_block_num() )
+         if( new_head->num > head_block_num() )
          {
-            // wlog( "Switching to fork: ${id}", ("id",new_head->data.id()) );
-            auto branches = _fork_db.fetch_branch_from(new_head->data.id(), head_block_id());
+            // Buffered blocks that build on the new block were linked in behind it and extend the current chain
+            if( new_block.previous == head_block_id() )
+            {
+               fork_database::branch_type extension;
+               for( auto item = new_head; item && item->num > head_block_num(); item = item->prev.lock() )
+                  extension.push_back( item );
+
+               if( extension.size() && extension.back()->previous_id() == head_block_id() )
+               {
+                  for( auto ritr = extension.rbegin(); ritr != extension.rend(); ++ritr )
+                  {
+                     try
+                     {
+                        apply_fork_item( **ritr, skip );
+                     }
+                     catch( const fc::exception& e )
+                     {
+                        // The failed block's undo session may have rolled back hardforks it applied
+                        update_hardfork_cache();
+
+                        // Drop this block and those built on it, the chain stays at the last block applied
+                        bool pushed_block_failed = (*ritr)->id == new_block_id;
+                        for( auto itr = ritr; itr != extension.rend(); ++itr )
+                           _fork_db.remove( (*itr)->id );
+                        _fork_db.set_head( _fork_db.fetch_block( head_block_id() ) );
+
+                        if( pushed_block_failed )
+                        {
+                           elog("Failed to push new block:\n${e}", ("e", e.to_detail_string()));
+                           throw;
+                        }
+
+                        wlog( "Buffered block ${id} failed to apply: ${e}", ("id",(*ritr)->id)("e",e.to_detail_string()) );
+                        break;
+                     }
+                  }
+                  return false;
+               }
+            }
+
+            // wlog( "Switching to fork: ${id}", ("id",new_head->id) );
+            auto switch_start = fc::time_point::now();
+            auto branches = _fork_db.fetch_branch_from(new_head->id, head_block_id());
 
             // pop blocks until we hit the forked block
-            while( head_block_id() != branches.second.back()->data.previous )
+            uint32_t popped = 0;
+            while( head_block_id() != branches.second.back()->previous_id() )
+            {
                pop_block();
+               ++popped;
+            }
 
             // push all blocks on the new fork
+            uint32_t revalidated = 0;
             for( auto ritr = branches.first.rbegin(); ritr != branches.first.rend(); ++ritr )
             {
-                // ilog( "pushing blocks from fork ${n} ${id}", ("n",(*ritr)->data.block_num())("id",(*ritr)->data.id()) );
+                // ilog( "pushing blocks from fork ${n} ${id}", ("n",(*ritr)->num)("id",(*ritr)->id) );
                 optional<fc::exception> except;
                 try
                 {
-                   auto session = start_undo_session( true );
-                   apply_block( (*ritr)->data, skip );
-                   session.push();
+                   if( (*ritr)->applied )
+                      ++revalidated;
+                   apply_fork_item( **ritr, skip );
                 }
                 catch ( const fc::exception& e ) { except = e; }
                 if( except )
@@ -585,25 +831,28 @@ bool database::_push_block(const signed_block& new_block)
                    // remove the rest of branches.first from the fork_db, those blocks are invalid
                    while( ritr != branches.first.rend() )
                    {
-                      _fork_db.remove( (*ritr)->data.id() );
+                      _fork_db.remove( (*ritr)->id );
                       ++ritr;
                    }
                    _fork_db.set_head( branches.second.front() );
 
                    // pop all blocks from the bad fork
-                   while( head_block_id() != branches.second.back()->data.previous )
+                   while( head_block_id() != branches.second.back()->previous_id() )
                       pop_block();
 
-                   // restore all blocks from the good fork
+                   // restore all blocks from the good fork, they were all applied before
                    for( auto ritr = branches.second.rbegin(); ritr != branches.second.rend(); ++ritr )
-                   {
-                      auto session = start_undo_session( true );
-                      apply_block( (*ritr)->data, skip );
-                      session.push();
-                   }
+                      apply_fork_item( **ritr, skip );
+
+                   wlog( "Fork switch to ${id} failed and was rolled back in ${t} ms",
+                      ("id",new_head->id)("t",( fc::time_point::now() - switch_start ).count() / 1000) );
                    throw *except;
                 }
             }
+
+            ilog( "Switched to fork ${id}: popped ${p} blocks, applied ${a} (${r} previously applied) in ${t} ms",
+               ("id",new_head->id)("p",popped)("a",branches.first.size())("r",revalidated)
+               ("t",( fc::time_point::now() - switch_start ).count() / 1000) );
             return true;
          }
          else
@@ -620,13 +869,31 @@ bool database::_push_block(const signed_block& new_block)
    catch( const fc::exception& e )
    {
       elog("Failed to push new block:\n${e}", ("e", e.to_detail_string()));
-      _fork_db.remove(new_block.id());
+      _fork_db.remove(new_block_id);
       throw;
    }
 
+   if( !(skip&skip_fork_db) )
+   {
+      auto item = _fork_db.fetch_block( new_block_id );
+      if( item )
+         item->applied = true;
+   }
+
    return false;
 } FC_CAPTURE_AND_RETHROW() }
 
+void database::apply_fork_item( fork_item& item, uint32_t skip )
+{
+   if( item.applied )
+      skip |= skip_witness_signature | skip_transaction_signatures | skip_authority_check | skip_merkle_check | skip_validate;
+
+   auto session = start_undo_session( true );
+   apply_block( *item.data, skip );
+   session.push();
+   item.applied = true;
+}
+
 /**
  * Attempts to push the transaction into the pending queue
  *
@@ -639,31 +906,64 @@ bool database::_push_block(const signed_block& new_block)
 void database::push_transaction( const signed_transaction& trx, uint32_t skip )
 {
    try
+   {
+      push_prepared_transaction( prepare_transaction( trx, skip ), skip );
+   }
+   FC_CAPTURE_AND_RETHROW( (trx) )
+}
+
+prepared_transaction database::prepare_transaction( const signed_transaction& trx, uint32_t skip )
+{
+   prepared_transaction ptrx( trx, CHAIN_ID );
+
+   if( !( skip & skip_validate ) )
+   {
+      trx.validate();
+      ptrx.validated = true;
+   }
+
+   // On failure the keys are recovered again in _apply_transaction so the error is reported as before
+   if( !( skip & ( skip_transaction_signatures | skip_authority_check ) ) )
    {
       try
       {
-         FC_ASSERT( fc::raw::pack_size(trx) <= (get_dynamic_global_properties().maximum_block_size - 256) );
-         set_producing( true );
-         detail::with_skip_flags( *this, skip,
-            [&]()
+         ptrx.signature_keys = _signature_cache.get_signature_keys( ptrx );
+      }
+      catch( const fc::exception& ) {}
+   }
+
+   return ptrx;
+}
+
+void database::push_prepared_transaction( const prepared_transaction& ptrx, uint32_t skip )
+{
+   try
+   {
+      set_producing( true );
+      detail::with_skip_flags( *this, skip,
+         [&]()
+         {
+            with_write_lock( [&]()
             {
-               with_write_lock( [&]()
-               {
-                  _push_transaction( trx );
-               });
+               FC_ASSERT( ptrx.packed_size() <= (get_dynamic_global_properties().maximum_block_size - 256) );
+               _push_transaction( ptrx );
             });
-         set_producing( false );
-      }
-      catch( ... )
-      {
-         set_producing( false );
-         throw;
-      }
+         });
+      set_producing( false );
+   }
+   catch( ... )
+   {
+      set_producing( false );
+      throw;
    }
-   FC_CAPTURE_AND_RETHROW( (trx) )
 }
 
 void database::_push_transaction( const signed_transaction& trx )
+{
+   _push_transaction( prepared_transaction( trx, CHAIN_ID ) );
+}
+
+void database::_push_transaction( const prepared_transaction& trx )
 {
    // If this is the first transaction pushed after applying a block, start a new undo session.
    // This allows us to quickly rewind to the clean state of the head block, in case a new block arrives.
@@ -675,16 +975,24 @@ void database::_push_transaction( const signed_transaction& trx )
    // _apply_transaction fails.  If we make it to merge(), we
    // apply the changes.
 
+   _pending_tx.check_capacity( trx );
+
    auto temp_session = start_undo_session( true );
    _apply_transaction( trx );
-   _pending_tx.push_back( trx );
+   // The dupe check may be skipped, a transaction already pending must not be applied twice
+   bool added = _pending_tx.push( trx );
+   FC_ASSERT( added, "Transaction is already pending", ("id", trx.id()) );
+
+   _pending_tx_size += trx.packed_size();
+   _pending_tx_skip_flags |= get_node_properties().skip_flags;
+   _pending_tx_min_expiration = std::min( _pending_tx_min_expiration, trx.get_transaction().expiration );
 
    notify_changed_objects();
    // The transaction applied successfully. Merge its changes into the pending block session.
    temp_session.squash();
 
    // notify anyone listening to pending transactions
-   notify_on_pending_transaction( trx );
+   notify_on_pending_transaction( trx.get_transaction() );
 }
 
 signed_block database::generate_block(
@@ -756,8 +1064,30 @@ signed_block database::_generate_block(
    size_t total_block_size = fc::raw::pack_size( pending_block ) + 4;
    auto maximum_block_size = get_dynamic_global_properties().maximum_block_size; //MAX_BLOCK_SIZE;
 
+   vector< digest_type > merkle_ids;
+
    with_write_lock( [&]()
    {
+      //
+      // Every pending transaction was applied in order on top of the head block, which is the same state
+      // and head block time the rebuild below would apply them to. When all of them fit in the block, none
+      // expire before it and none were applied skipping a check this block does not skip, the pending state
+      // already is the block's state and the transactions are taken as they are.
+      //
+      if( _pending_tx_session.valid()
+         && total_block_size + _pending_tx_size < maximum_block_size
+         && _pending_tx_min_expiration >= when
+         && !( _pending_tx_skip_flags & ~skip ) )
+      {
+         _pending_tx.for_each( [&]( const prepared_transaction& tx )
+         {
+            pending_block.transactions.push_back( tx.get_transaction() );
+            merkle_ids.push_back( tx.merkle_digest() );
+         });
+         _pending_tx_session.reset();
+         return;
+      }
+
       //
       // The following code throws away existing pending_tx_session and
       // rebuilds it by re-applying pending transactions.
@@ -774,21 +1104,21 @@ signed_block database::_generate_block(
 
       uint64_t postponed_tx_count = 0;
       // pop pending state (reset to head block state)
-      for( const signed_transaction& tx : _pending_tx )
+      _pending_tx.for_each( [&]( const prepared_transaction& tx )
       {
          // Only include transactions that have not expired yet for currently generating block,
          // this should clear problem transactions and allow block production to continue
 
-         if( tx.expiration < when )
-            continue;
+         if( tx.get_transaction().expiration < when )
+            return;
 
-         uint64_t new_total_size = total_block_size + fc::raw::pack_size( tx );
+         uint64_t new_total_size = total_block_size + tx.packed_size();
 
          // postpone transaction if it would make block too big
          if( new_total_size >= maximum_block_size )
          {
             postponed_tx_count++;
-            continue;
+            return;
          }
 
          try
@@ -797,8 +1127,9 @@ signed_block database::_generate_block(
             _apply_transaction( tx );
             temp_session.squash();
 
-            total_block_size += fc::raw::pack_size( tx );
-            pending_block.transactions.push_back( tx );
+            total_block_size += tx.packed_size();
+            pending_block.transactions.push_back( tx.get_transaction() );
+            merkle_ids.push_back( tx.merkle_digest() );
          }
          catch ( const fc::exception& e )
          {
@@ -806,7 +1137,7 @@ signed_block database::_generate_block(
             //wlog( "Transaction was not processed while generating block due to ${e}", ("e", e) );
             //wlog( "The transaction was ${t}", ("t", tx) );
          }
-      }
+      });
       if( postponed_tx_count > 0 )
       {
          wlog( "Postponed ${n} transactions due to block size limit", ("n", postponed_tx_count) );
@@ -821,7 +1152,7 @@ signed_block database::_generate_block(
    // However, the push_block() call below will re-create the
    // _pending_tx_session.
 
-   pending_block.transaction_merkle_root = pending_block.calculate_merkle_root();
+   pending_block.transaction_merkle_root = calculate_merkle_root( std::move( merkle_ids ) );
 
    if( !(skip & skip_witness_signature) )
       pending_block.sign( block_signing_private_key );
@@ -849,11 +1180,12 @@ void database::pop_block()
       auto head_id = head_block_id();
 
       /// save the head block so we can recover its transactions
-      optional<signed_block> head_block = fetch_block_by_id( head_id );
-      ASSERT( head_block.valid(), pop_empty_chain, "there are no blocks to pop" );
+      signed_block_ptr head_block = fetch_shared_block_by_id( head_id );
+      ASSERT( head_block, pop_empty_chain, "there are no blocks to pop" );
 
       _fork_db.pop_block();
       undo();
+      update_hardfork_cache();
 
       _popped_tx.insert( _popped_tx.begin(), head_block->transactions.begin(), head_block->transactions.end() );
 
@@ -865,9 +1197,12 @@ void database::clear_pending()
 {
    try
    {
-      assert( (_pending_tx.size() == 0) || _pending_tx_session.valid() );
+      assert( _pending_tx.empty() || _pending_tx_session.valid() );
       _pending_tx.clear();
       _pending_tx_session.reset();
+      _pending_tx_size = 0;
+      _pending_tx_skip_flags = 0;
+      _pending_tx_min_expiration = fc::time_point_sec::maximum();
    }
    FC_CAPTURE_AND_RETHROW()
 }
@@ -878,16 +1213,214 @@ void database::notify_pre_apply_operation( operation_notification& note )
    note.block        = _current_block_num;
    note.trx_in_block = _current_trx_in_block;
    note.op_in_trx    = _current_op_in_trx;
+   note.timestamp    = head_block_time();
 
-   TRY_NOTIFY( pre_apply_operation, note )
+   notify_operation_handlers( note, true );
+   notify_deferrable_operation_handlers( note, true );
 }
 
 void database::notify_post_apply_operation( const operation_notification& note )
 {
-   TRY_NOTIFY( post_apply_operation, note )
+   notify_operation_handlers( note, false );
+   notify_deferrable_operation_handlers( note, false );
+}
+
+void database::notify_operation_handlers( const operation_notification& note, bool pre_apply )
+{
+   const auto& handlers = pre_apply ? _pre_apply_operation_handlers : _post_apply_operation_handlers;
+
+   for( const auto& handler : handlers[ note.op.which() ] )
+   {
+      TRY_NOTIFY( handler, note )
+   }
+}
+
+void database::subscribe_operation( int64_t op_tag, const operation_handler& handler, bool pre_apply )
+{
+   auto& handlers = pre_apply ? _pre_apply_operation_handlers : _post_apply_operation_handlers;
+   FC_ASSERT( op_tag >= 0 && op_tag < int64_t( handlers.size() ), "Unknown operation tag", ("op_tag", op_tag) );
+   handlers[ op_tag ].push_back( handler );
+}
+
+void database::subscribe_all_operations( const operation_handler& handler, bool pre_apply )
+{
+   auto& handlers = pre_apply ? _pre_apply_operation_handlers : _post_apply_operation_handlers;
+   for( auto& h : handlers )
+      h.push_back( handler );
+}
+
+void database::notify_deferrable_operation_handlers( const operation_notification& note, bool pre_apply )
+{
+   if( _deferrable_operation_handlers.empty() )
+      return;
+
+   if( _defer_operation_notifications )
+   {
+      _deferred_operation_notifications.emplace_back( note, pre_apply );
+      return;
+   }
+
+   for( const auto& h : _deferrable_operation_handlers )
+   {
+      if( h.pre_apply != pre_apply )
+         continue;
+
+      TRY_NOTIFY( h.handler, note )
+   }
+}
+
+void database::add_deferrable_operation_handler( const std::function< void( const operation_notification& ) >& handler, bool pre_apply )
+{
+   deferrable_operation_handler h;
+   h.handler = handler;
+   h.pre_apply = pre_apply;
+   _deferrable_operation_handlers.push_back( h );
+}
+
+void database::set_deferred_notification_blocks( uint32_t notification_blocks )
+{
+   _deferred_notification_blocks = notification_blocks;
+}
+
+void database::flush_deferred_operation_notifications()
+{ try {
+   if( _deferred_operation_notifications.empty() )
+      return;
+
+   /**
+    * Each handler walks the whole buffer in order on its own worker. Handlers only write to the indexes
+    * they own, so they do not contend with each other and consensus state is not modified meanwhile.
+    */
+   vector< optional< plugin_exception > > failures( _deferrable_operation_handlers.size() );
+
+   auto dispatch = [&]( size_t i )
+   {
+      const auto& h = _deferrable_operation_handlers[i];
+      try
+      {
+         for( const auto& d : _deferred_operation_notifications )
+         {
+            if( d.pre_apply != h.pre_apply )
+               continue;
+
+            TRY_NOTIFY( h.handler, d.get_notification() )
+         }
+      }
+      catch( const plugin_exception& e )
+      {
+         // Stop this handler and let the others finish before rethrowing
+         failures[i] = e;
+      }
+   };
+
+   run_parallel( _deferrable_operation_handlers.size(), [&]( size_t begin, size_t end )
+   {
+      for( size_t i = begin; i < end; i++ )
+         dispatch( i );
+   });
+
+   _deferred_operation_notifications.clear();
+
+   for( const auto& f : failures )
+      if( f )
+         throw *f;
+} FC_CAPTURE_AND_RETHROW() }
+
+void database::set_thread_pool_size( uint32_t num_threads )
+{
+   _thread_pool.resize( num_threads );
+   for( auto& t : _thread_pool )
+      if( !t )
+         t = std::make_shared< fc::thread >();
+}
+
+void database::run_parallel( size_t count, const std::function< void( size_t, size_t ) >& f )const
+{
+   if( count == 0 )
+      return;
+
+   size_t num_ranges = std::min< size_t >( _thread_pool.size(), count );
+   if( num_ranges <= 1 )
+   {
+      f( 0, count );
+      return;
+   }
+
+   // std::future blocks this thread instead of yielding to other fc tasks, which must not run while we hold a lock
+   std::vector< std::future< void > > results;
+   results.reserve( num_ranges );
+
+   for( size_t i = 0; i < num_ranges; i++ )
+   {
+      size_t begin = count * i / num_ranges;
+      size_t end = count * ( i + 1 ) / num_ranges;
+      auto done = std::make_shared< std::promise< void > >();
+      results.push_back( done->get_future() );
+
+      _thread_pool[i]->async( [&f,begin,end,done]()
+      {
+         try
+         {
+            f( begin, end );
+            done->set_value();
+         }
+         catch( ... )
+         {
+            done->set_exception( std::current_exception() );
+         }
+      });
+   }
+
+   for( auto& r : results )
+      r.wait();
+
+   for( auto& r : results )
+      r.get();
 }
 
-inline const void database::push_virtual_operation( const operation& op, bool force )
+vector< prepared_transaction > database::prepare_transactions( const signed_block& b, uint32_t skip )
+{
+   vector< optional< prepared_transaction > > prepared( b.transactions.size() );
+   const chain_id_type& chain_id = CHAIN_ID;
+   bool validate = !( skip & skip_validate );
+   bool recover_keys = !( skip & ( skip_transaction_signatures | skip_authority_check ) );
+
+   run_parallel( b.transactions.size(), [&]( size_t begin, size_t end )
+   {
+      for( size_t i = begin; i < end; i++ )
+      {
+         prepared[i] = prepared_transaction( b.transactions[i], chain_id );
+
+         if( validate )
+         {
+            try
+            {
+               b.transactions[i].validate();
+               prepared[i]->validated = true;
+            }
+            catch( const fc::exception& ) {}
+         }
+
+         if( recover_keys )
+         {
+            try
+            {
+               prepared[i]->signature_keys = _signature_cache.get_signature_keys( *prepared[i] );
+            }
+            catch( const fc::exception& ) {}
+         }
+      }
+   });
+
+   vector< prepared_transaction > result;
+   result.reserve( prepared.size() );
+   for( auto& p : prepared )
+      result.push_back( std::move( *p ) );
+
+   return result;
+}
+
+void database::notify_virtual_operation( const operation& op, bool force )
 {
 /*
    if( !force )
@@ -908,6 +1441,40 @@ void database::notify_applied_block( const signed_block& block )
    TRY_NOTIFY( applied_block, block )
 }
 
+checksum_type database::calculate_merkle_root( vector< digest_type > ids )const
+{
+   // Below this many pairs a level is cheaper to hash than to hand out to the thread pool
+   const size_t min_parallel_pairs = 512;
+
+   while( ids.size() / 2 >= min_parallel_pairs )
+   {
+      size_t pairs = ids.size() / 2;
+      vector< digest_type > next( pairs + ( ids.size() & 1 ) );
+
+      run_parallel( pairs, [&]( size_t begin, size_t end )
+      {
+         for( size_t i = begin; i < end; i++ )
+            next[i] = digest_type::hash( std::make_pair( ids[2*i], ids[2*i+1] ) );
+      });
+
+      if( ids.size() & 1 )
+         next.back() = ids.back();
+      ids = std::move( next );
+   }
+
+   // Each level only depends on the one below it, so the rest of the tree can be finished serially
+   return signed_block::calculate_merkle_root( std::move( ids ) );
+}
+
+checksum_type database::calculate_merkle_root( const vector< prepared_transaction >& trxs )const
+{
+   vector< digest_type > ids;
+   ids.reserve( trxs.size() );
+   for( const auto& trx : trxs )
+      ids.push_back( trx.merkle_digest() );
+   return calculate_merkle_root( std::move( ids ) );
+}
+
 void database::notify_pre_apply_block( const signed_block& block )
 {
    TRY_NOTIFY( pre_apply_block, block )
@@ -1492,6 +2059,8 @@ share_type database::pay_curators( const comment_object& c, share_type& max_rewa
       else if( c.total_vote_weight > 0 )
       {
          const auto& cvidx = get_index<comment_vote_index>().indices().get<by_comment_weight_voter>();
+         const bool to_reward_balance = has_hardfork( HARDFORK_0_17__659 );
+         const std::string permlink = to_string( c.permlink );
          auto itr = cvidx.lower_bound( c.id );
          while( itr != cvidx.end() && itr->comment == c.id )
          {
@@ -1501,9 +2070,9 @@ share_type database::pay_curators( const comment_object& c, share_type& max_rewa
             {
                unclaimed_rewards -= claim;
                const auto& voter = get(itr->voter);
-               auto reward = createTMEfundForSCORE( voter, asset( claim, SYMBOL_COIN ), has_hardfork( HARDFORK_0_17__659 ) );
+               auto reward = createTMEfundForSCORE( voter, asset( claim, SYMBOL_COIN ), to_reward_balance );
 
-               push_virtual_operation( curationReward_operation( voter.name, reward, c.author, to_string( c.permlink ) ) );
+               push_virtual_operation( curationReward_operation( voter.name, reward, c.author, permlink ) );
 
                #ifndef IS_LOW_MEM
                   modify( voter, [&]( account_object& a )
@@ -1540,7 +2109,7 @@ share_type database::cashout_comment_helper( util::comment_reward_context& ctx,
 
          if( has_hardfork( HARDFORK_0_17__774 ) )
          {
-            const auto rf = get_reward_fund( comment );
+            const auto& rf = get_reward_fund( comment );
             ctx.reward_curve = rf.authorReward_curve;
             ctx.content_constant = rf.content_constant;
          }
@@ -1553,6 +2122,9 @@ share_type database::cashout_comment_helper( util::comment_reward_context& ctx,
             share_type curation_tokens = ( ( reward_tokens * get_curationRewards_percent( comment ) ) / PERCENT_100 ).to_uint64();
             share_type author_tokens = reward_tokens.to_uint64() - curation_tokens;
 
+            const bool to_reward_balance = has_hardfork( HARDFORK_0_17__659 );
+            const std::string permlink = to_string( comment.permlink );
+
             author_tokens += pay_curators( comment, curation_tokens );
             share_type total_beneficiary = 0;
             claimed_reward = author_tokens + curation_tokens;
@@ -1560,8 +2132,8 @@ share_type database::cashout_comment_helper( util::comment_reward_context& ctx,
             for( auto& b : comment.beneficiaries )
             {
                auto benefactor_tokens = ( author_tokens * b.weight ) / PERCENT_100;
-               auto TMEfundForSCOREcreated = createTMEfundForSCORE( get_account( b.account ), benefactor_tokens, has_hardfork( HARDFORK_0_17__659 ) );
-               push_virtual_operation( comment_benefactor_reward_operation( b.account, comment.author, to_string( comment.permlink ), TMEfundForSCOREcreated ) );
+               auto TMEfundForSCOREcreated = createTMEfundForSCORE( get_account( b.account ), benefactor_tokens, to_reward_balance );
+               push_virtual_operation( comment_benefactor_reward_operation( b.account, comment.author, permlink, TMEfundForSCOREcreated ) );
                total_beneficiary += benefactor_tokens;
             }
 
@@ -1571,13 +2143,13 @@ share_type database::cashout_comment_helper( util::comment_reward_context& ctx,
             auto SCOREvalueInTME = author_tokens - TSDvalueInTME;
 
             const auto& author = get_account( comment.author );
-            auto TMEfundForSCOREcreated = createTMEfundForSCORE( author, SCOREvalueInTME, has_hardfork( HARDFORK_0_17__659 ) );
-            auto TSDpayout = create_TSD( author, TSDvalueInTME, has_hardfork( HARDFORK_0_17__659 ) );
+            auto TMEfundForSCOREcreated = createTMEfundForSCORE( author, SCOREvalueInTME, to_reward_balance );
+            auto TSDpayout = create_TSD( author, TSDvalueInTME, to_reward_balance );
 
             adjust_total_payout( comment, TSDpayout.first + to_TSD( TSDpayout.second + asset( SCOREvalueInTME, SYMBOL_COIN ) ), to_TSD( asset( curation_tokens, SYMBOL_COIN ) ), to_TSD( asset( total_beneficiary, SYMBOL_COIN ) ) );
 
-            push_virtual_operation( authorReward_operation( comment.author, to_string( comment.permlink ), TSDpayout.first, TSDpayout.second, TMEfundForSCOREcreated ) );
-            push_virtual_operation( comment_reward_operation( comment.author, to_string( comment.permlink ), to_TSD( asset( claimed_reward, SYMBOL_COIN ) ) ) );
+            push_virtual_operation( authorReward_operation( comment.author, permlink, TSDpayout.first, TSDpayout.second, TMEfundForSCOREcreated ) );
+            push_virtual_operation( comment_reward_operation( comment.author, permlink, to_TSD( asset( claimed_reward, SYMBOL_COIN ) ) ) );
 
             #ifndef IS_LOW_MEM
                modify( comment, [&]( comment_object& c )
@@ -1699,47 +2271,44 @@ void database::process_comment_cashout()
    const auto& cidx        = get_index< comment_index >().indices().get< by_cashout_time >();
    const auto& com_by_root = get_index< comment_index >().indices().get< by_root >();
 
-   auto current = cidx.begin();
-   //  add all SCOREreward about to be cashed out to the reward funds. This ensures equal satoshi per rshare payment
    if( has_hardfork( HARDFORK_0_17__771 ) )
    {
-      while( current != cidx.end() && current->cashout_time <= head_block_time() )
+      /*
+       * Collect the due comments in a single pass, adding the SCOREreward about to be cashed out to the
+       * reward funds. This ensures equal satoshi per rshare payment. Each payout is then made against
+       * the reward fund state snapshotted here.
+       *
+       * Paying a comment only moves that comment's own cashout time to the maximum, so paying the
+       * collected comments in index order is the same order as repeatedly paying cidx.begin().
+       * Payouts are still applied one at a time because each SCORE purchase moves the SCORE price
+       * seen by the next one.
+       */
+      vector< std::pair< const comment_object*, int64_t > > due;
+
+      for( auto current = cidx.begin(); current != cidx.end() && current->cashout_time <= head_block_time(); ++current )
       {
+         const auto& rf = get_reward_fund( *current );
+
          if( current->net_SCOREreward > 0 )
-         {
-            const auto& rf = get_reward_fund( *current );
             funds[ rf.id._id ].recent_claims += util::evaluate_reward_curve( current->net_SCOREreward.value, rf.authorReward_curve, rf.content_constant );
-         }
 
-         ++current;
+         due.emplace_back( &(*current), rf.id._id );
       }
 
-      current = cidx.begin();
-   }
-
-   /*
-    * Payout all comments
-    *
-    * Each payout follows a similar pattern, but for a different reason.
-    * Cashout comment helper does not know about the reward fund it is paying from.
-    * The helper only does token allocation based on curation rewards and the TSD
-    * global %, etc.
-    *
-    * Each context is used by get_SCORE_reward to determine what part of each budget
-    * the comment is entitled to. Prior to hardfork 17, all payouts are done against
-    * the global state updated each payout. After the hardfork, each payout is done
-    * against a reward fund state that is snapshotted before all payouts in the block.
-    */
-   while( current != cidx.end() && current->cashout_time <= head_block_time() )
-   {
-      if( has_hardfork( HARDFORK_0_17__771 ) )
+      for( const auto& d : due )
       {
-         auto fund_id = get_reward_fund( *current ).id._id;
-         ctx.totalSCOREreward2 = funds[ fund_id ].recent_claims;
-         ctx.total_reward_fund_TME = funds[ fund_id ].reward_balance;
-         funds[ fund_id ].TME_awarded += cashout_comment_helper( ctx, *current );
+         ctx.totalSCOREreward2 = funds[ d.second ].recent_claims;
+         ctx.total_reward_fund_TME = funds[ d.second ].reward_balance;
+         funds[ d.second ].TME_awarded += cashout_comment_helper( ctx, *d.first );
       }
-      else
+   }
+   else
+   {
+      /*
+       * Prior to hardfork 17, all payouts are done against the global state updated each payout.
+       */
+      auto current = cidx.begin();
+      while( current != cidx.end() && current->cashout_time <= head_block_time() )
       {
          auto itr = com_by_root.lower_bound( current->root_comment );
          while( itr != com_by_root.end() && itr->root_comment == current->root_comment )
@@ -1758,9 +2327,9 @@ void database::process_comment_cashout()
                });
             }
          }
-      }
 
-      current = cidx.begin();
+         current = cidx.begin();
+      }
    }
 
    // Write the cached fund state back to the database
@@ -2033,6 +2602,9 @@ void database::process_conversions()
    const auto& request_by_date = get_index< convert_request_index >().indices().get< by_conversion_date >();
    auto itr = request_by_date.begin();
 
+   if( itr == request_by_date.end() || itr->conversion_date > now )
+      return;
+
    const auto& fhistory = get_feed_history();
    if( fhistory.current_median_history.is_null() )
       return;
@@ -2447,6 +3019,7 @@ void database::init_genesis( uint64_t init_supply )
          hpo.processed_hardforks.push_back( GENESIS_TIME );
 
       } );
+      update_hardfork_cache();
 
       // Create witness scheduler
       create< witness_schedule_object >( [&]( witness_schedule_object& wso )
@@ -2463,7 +3036,7 @@ void database::validate_transaction( const signed_transaction& trx )
    database::with_write_lock( [&]()
    {
       auto session = start_undo_session( true );
-      _apply_transaction( trx );
+      _apply_transaction( prepared_transaction( trx, CHAIN_ID ) );
       session.undo();
    });
 }
@@ -2503,21 +3076,28 @@ void database::set_flush_interval( uint32_t flush_blocks )
    _next_flush_block = 0;
 }
 
+void database::set_max_unlinked_blocks( uint32_t max_blocks )
+{
+   _fork_db.set_max_unlinked( max_blocks );
+}
+
 //////////////////// private methods ////////////////////
 
 void database::apply_block( const signed_block& next_block, uint32_t skip )
 { try {
-   //fc::time_point begin_time = fc::time_point::now();
-
    auto block_num = next_block.block_num();
+   _block_timer.start_block( block_num );
+
+   const block_id_type next_block_id = next_block.id();
    if( _checkpoints.size() && _checkpoints.rbegin()->second != block_id_type() )
    {
       auto itr = _checkpoints.find( block_num );
       if( itr != _checkpoints.end() )
-         FC_ASSERT( next_block.id() == itr->second, "Block did not match checkpoint", ("checkpoint",*itr)("block_id",next_block.id()) );
+         FC_ASSERT( next_block_id == itr->second, "Block did not match checkpoint", ("checkpoint",*itr)("block_id",next_block_id) );
 
       if( _checkpoints.rbegin()->first >= block_num )
-         skip = skip_witness_signature
+         skip = ( skip & skip_undo_block )
+              | skip_witness_signature
               | skip_transaction_signatures
               | skip_transaction_dupe_check
               | skip_fork_db
@@ -2534,19 +3114,18 @@ void database::apply_block( const signed_block& next_block, uint32_t skip )
 
    detail::with_skip_flags( *this, skip, [&]()
    {
-      _apply_block( next_block );
+      _apply_block( next_block, next_block_id );
    } );
 
-   /*try
+   try
    {
-   /// check invariants
+   /// check invariants against the changes made by this block
    if( is_producing() || !( skip & skip_validate_invariants ) )
-      validate_invariants();
+      validate_supply_delta();
    }
-   FC_CAPTURE_AND_RETHROW( (next_block) );*/
+   FC_CAPTURE_AND_RETHROW( (next_block) );
+   _block_timer.mark( block_timer::stage_invariants );
 
-   //fc::time_point end_time = fc::time_point::now();
-   //fc::microseconds dt = end_time - begin_time;
    if( _flush_blocks != 0 )
    {
       if( _next_flush_block == 0 )
@@ -2573,9 +3152,37 @@ void database::apply_block( const signed_block& next_block, uint32_t skip )
          chainbase::database::flush();
       }
    }
+   _block_timer.mark( block_timer::stage_flush );
+
+   auto slow_block = _block_timer.finish_block( next_block.transactions.size() );
+   if( slow_block )
+      wlog( "Block ${n} took ${t} ms to apply: ${r}", ("n", block_num)("t", slow_block->total.count() / 1000)("r", *slow_block) );
 
    show_free_memory( false );
 
+   if( _invariant_audit_blocks && block_num % _invariant_audit_blocks == 0 )
+   {
+      // A failed audit is reported rather than rejecting a block that consensus already accepted
+      try
+      {
+         validate_invariants();
+      }
+      catch( const fc::exception& e )
+      {
+         elog( "Invariant audit failed at block ${b}: ${e}", ("b", block_num)("e", e.to_detail_string()) );
+      }
+   }
+
+   if( block_num % 1200 == 0 )
+   {
+      auto stats = _signature_cache.get_stats();
+      if( stats.hits + stats.misses )
+         ilog( "Signature cache hit rate ${r}%, ${s}", ("r", stats.hits * 100 / ( stats.hits + stats.misses ))("s", stats) );
+      dlog( "Deadline processing timings: ${t}", ("t", _deadline_timings) );
+      dlog( "Pending transaction pool: ${s}", ("s", _pending_tx.get_stats()) );
+      dlog( "Unlinked block buffer: ${s}", ("s", _fork_db.get_unlinked_stats()) );
+   }
+
 } FC_CAPTURE_AND_RETHROW( (next_block) ) }
 
 void database::show_free_memory( bool force )
@@ -2596,22 +3203,34 @@ void database::show_free_memory( bool force )
    }
 }
 
-void database::_apply_block( const signed_block& next_block )
+void database::_apply_block( const signed_block& next_block, const block_id_type& next_block_id )
 { try {
+   // Blocks may have been undone since the last one was applied
+   update_hardfork_cache();
+
    notify_pre_apply_block( next_block );
 
    uint32_t next_block_num = next_block.block_num();
-   //block_id_type next_block_id = next_block.id();
 
    uint32_t skip = get_node_properties().skip_flags;
 
+   // Transactions prepared by push_block are reused, their merkle digests included
+   vector< prepared_transaction > prepared;
+   if( _prepared_block_transactions.size() == next_block.transactions.size() && _prepared_block_id == next_block_id )
+      prepared = std::move( _prepared_block_transactions );
+   else
+      prepared = prepare_transactions( next_block, skip );
+   _prepared_block_transactions.clear();
+   _prepared_block_id = block_id_type();
+   _block_timer.mark( block_timer::stage_prepare );
+
    if( !( skip & skip_merkle_check ) )
    {
-      auto merkle_root = next_block.calculate_merkle_root();
+      auto merkle_root = calculate_merkle_root( prepared );
 
       try
       {
-         FC_ASSERT( next_block.transaction_merkle_root == merkle_root, "Merkle check failed", ("next_block.transaction_merkle_root",next_block.transaction_merkle_root)("calc",merkle_root)("next_block",next_block)("id",next_block.id()) );
+         FC_ASSERT( next_block.transaction_merkle_root == merkle_root, "Merkle check failed", ("next_block.transaction_merkle_root",next_block.transaction_merkle_root)("calc",merkle_root)("next_block",next_block)("id",next_block_id) );
       }
       catch( fc::assert_exception& e )
       {
@@ -2622,6 +3241,7 @@ void database::_apply_block( const signed_block& next_block )
             throw e;
       }
    }
+   _block_timer.mark( block_timer::stage_merkle );
 
    const witness_object& signing_witness = validate_block_header(skip, next_block);
 
@@ -2661,7 +3281,9 @@ void database::_apply_block( const signed_block& next_block )
       );
    }
 
-   for( const auto& trx : next_block.transactions )
+   _block_timer.mark( block_timer::stage_header );
+
+   for( const auto& trx : prepared )
    {
       /* We do not need to push the undo state for each transaction
        * because they either all apply and are valid or the
@@ -2672,44 +3294,73 @@ void database::_apply_block( const signed_block& next_block )
       apply_transaction( trx, skip );
       ++_current_trx_in_block;
    }
+   _block_timer.mark( block_timer::stage_transactions );
 
-   update_global_dynamic_data(next_block);
+   update_global_dynamic_data( next_block, next_block_id );
    update_signing_witness(signing_witness, next_block);
+   _block_timer.mark( block_timer::stage_global_properties );
 
    update_last_irreversible_block();
-
-   create_block_summary(next_block);
-   clear_expired_transactions();
-   clear_expired_orders();
-   clear_expired_delegations();
+   _block_timer.mark( block_timer::stage_irreversible );
+
+   create_block_summary( next_block, next_block_id );
+   _block_timer.mark( block_timer::stage_global_properties );
+   run_deadline_processing( deadline_transactions, &database::clear_expired_transactions );
+   run_deadline_processing( deadline_orders, &database::clear_expired_orders );
+   run_deadline_processing( deadline_delegations, &database::clear_expired_delegations );
+   _block_timer.mark( block_timer::stage_expirations );
    update_witness_schedule(*this);
+   _block_timer.mark( block_timer::stage_witness_schedule );
 
    update_median_feed();
    update_virtual_supply();
+   _block_timer.mark( block_timer::stage_feeds );
 
    clear_null_account_balance();
    process_funds();
-   process_conversions();
-   process_comment_cashout();
-   process_TME_fund_for_SCORE_withdrawals();
-   process_savings_withdraws();
+   _block_timer.mark( block_timer::stage_funds );
+   run_deadline_processing( deadline_conversions, &database::process_conversions );
+   _block_timer.mark( block_timer::stage_conversions );
+   run_deadline_processing( deadline_comment_cashout, &database::process_comment_cashout );
+   _block_timer.mark( block_timer::stage_comment_cashout );
+   run_deadline_processing( deadline_SCORE_withdrawals, &database::process_TME_fund_for_SCORE_withdrawals );
+   _block_timer.mark( block_timer::stage_SCORE_withdrawals );
+   run_deadline_processing( deadline_savings_withdraws, &database::process_savings_withdraws );
+   _block_timer.mark( block_timer::stage_savings_withdraws );
    pay_liquidity_reward();
    update_virtual_supply();
+   _block_timer.mark( block_timer::stage_liquidity_reward );
 
-   account_recovery_processing();
-   expire_escrow_ratification();
-   process_decline_voting_rights();
+   run_deadline_processing( deadline_account_recovery, &database::account_recovery_processing );
+   run_deadline_processing( deadline_escrow_ratification, &database::expire_escrow_ratification );
+   run_deadline_processing( deadline_decline_voting_rights, &database::process_decline_voting_rights );
+   _block_timer.mark( block_timer::stage_account_deadlines );
 
    process_hardforks();
+   _block_timer.mark( block_timer::stage_hardforks );
 
    // notify observers that the block has been applied
    notify_applied_block( next_block );
 
    notify_changed_objects();
+   _block_timer.mark( block_timer::stage_notify );
 } //FC_CAPTURE_AND_RETHROW( (next_block.block_num()) )  }
 FC_CAPTURE_LOG_AND_RETHROW( (next_block.block_num()) )
 }
 
+void database::run_deadline_processing( deadline_category category, void (database::*process)() )
+{
+   auto start = fc::time_point::now();
+   (this->*process)();
+   auto elapsed = fc::time_point::now() - start;
+
+   auto& timing = _deadline_timings[ category ];
+   ++timing.runs;
+   timing.total += elapsed;
+   if( elapsed > timing.max )
+      timing.max = elapsed;
+}
+
 void database::process_header_extensions( const signed_block& next_block )
 {
    auto itr = next_block.extensions.begin();
@@ -2793,24 +3444,17 @@ try {
 
       modify( get_feed_history(), [&]( feed_history_object& fho )
       {
-         fho.price_history.push_back( median_feed );
+         fho.push_price( median_feed );
          size_t TMEfeed_history_window = FEED_HISTORY_WINDOW_PRE_HF_16;
          if( has_hardfork( HARDFORK_0_16__551) )
             TMEfeed_history_window = FEED_HISTORY_WINDOW;
 
          if( fho.price_history.size() > TMEfeed_history_window )
-            fho.price_history.pop_front();
+            fho.pop_oldest_price();
 
          if( fho.price_history.size() )
          {
-            std::deque< price > copy;
-            for( auto i : fho.price_history )
-            {
-               copy.push_back( i );
-            }
-
-            std::sort( copy.begin(), copy.end() ); /// TODO: use nth_item
-            fho.current_median_history = copy[copy.size()/2];
+            fho.current_median_history = fho.median_price();
 
 #ifdef IS_TEST_NET
             if( skip_price_feed_limit_check )
@@ -2829,23 +3473,24 @@ try {
    }
 } FC_CAPTURE_AND_RETHROW() }
 
-void database::apply_transaction(const signed_transaction& trx, uint32_t skip)
+void database::apply_transaction(const prepared_transaction& trx, uint32_t skip)
 {
    detail::with_skip_flags( *this, skip, [&]() { _apply_transaction(trx); });
-   notify_on_applied_transaction( trx );
+   notify_on_applied_transaction( trx.get_transaction() );
 }
 
-void database::_apply_transaction(const signed_transaction& trx)
+void database::_apply_transaction(const prepared_transaction& ptrx)
 { try {
-   _current_trx_id = trx.id();
+   const signed_transaction& trx = ptrx.get_transaction();
+   const transaction_id_type& trx_id = ptrx.id();
+
+   _current_trx_id = trx_id;
    uint32_t skip = get_node_properties().skip_flags;
 
-   if( !(skip&skip_validate) )   /* issue #505 explains why this skip_flag is disabled */
+   if( !(skip&skip_validate) && !ptrx.validated )   /* issue #505 explains why this skip_flag is disabled */
       trx.validate();
 
    auto& trx_idx = get_index<transaction_index>();
-   const chain_id_type& chain_id = CHAIN_ID;
-   auto trx_id = trx.id();
    // idump((trx_id)(skip&skip_transaction_dupe_check));
    FC_ASSERT( (skip & skip_transaction_dupe_check) ||
               trx_idx.indices().get<by_trx_id>().find(trx_id) == trx_idx.indices().get<by_trx_id>().end(),
@@ -2859,7 +3504,10 @@ void database::_apply_transaction(const signed_transaction& trx)
 
       try
       {
-         trx.verify_authority( chain_id, get_active, get_owner, get_posting, MAX_SIG_CHECK_DEPTH );
+         if( ptrx.signature_keys.valid() )
+            trx.verify_authority( *ptrx.signature_keys, get_active, get_owner, get_posting, MAX_SIG_CHECK_DEPTH );
+         else
+            trx.verify_authority( _signature_cache.get_signature_keys( ptrx ), get_active, get_owner, get_posting, MAX_SIG_CHECK_DEPTH );
       }
       catch( protocol::tx_missing_active_auth& e )
       {
@@ -2896,7 +3544,7 @@ void database::_apply_transaction(const signed_transaction& trx)
       create<transaction_object>([&](transaction_object& transaction) {
          transaction.trx_id = trx_id;
          transaction.expiration = trx.expiration;
-         fc::raw::pack( transaction.packed_trx, trx );
+         transaction.packed_trx.assign( ptrx.packed().begin(), ptrx.packed().end() );
       });
    }
 
@@ -2912,13 +3560,18 @@ void database::_apply_transaction(const signed_transaction& trx)
    }
    _current_trx_id = transaction_id_type();
 
-} FC_CAPTURE_AND_RETHROW( (trx) ) }
+} FC_CAPTURE_AND_RETHROW( (ptrx.get_transaction()) ) }
 
 void database::apply_operation(const operation& op)
 {
    operation_notification note(op);
    notify_pre_apply_operation( note );
+   auto changes = get_change_counters();
+   auto start = std::chrono::steady_clock::now();
    _my->_evaluator_registry.get_evaluator( op ).apply( op );
+   int64_t elapsed_ns = std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - start ).count();
+   _block_timer.record_operation( op.which(), fc::microseconds( elapsed_ns / 1000 ) );
+   _operation_profiler.record( op.which(), elapsed_ns, changes, get_change_counters() );
    notify_post_apply_operation( note );
 }
 
@@ -2945,15 +3598,15 @@ const witness_object& database::validate_block_header( uint32_t skip, const sign
    return witness;
 } FC_CAPTURE_AND_RETHROW() }
 
-void database::create_block_summary(const signed_block& next_block)
+void database::create_block_summary( const signed_block& next_block, const block_id_type& next_block_id )
 { try {
    block_summary_id_type sid( next_block.block_num() & 0xffff );
    modify( get< block_summary_object >( sid ), [&](block_summary_object& p) {
-         p.block_id = next_block.id();
+         p.block_id = next_block_id;
    });
 } FC_CAPTURE_AND_RETHROW() }
 
-void database::update_global_dynamic_data( const signed_block& b )
+void database::update_global_dynamic_data( const signed_block& b, const block_id_type& block_id )
 { try {
    const dynamic_global_property_object& _dgp =
       get_dynamic_global_properties();
@@ -2997,7 +3650,7 @@ void database::update_global_dynamic_data( const signed_block& b )
       }
 
       dgp.head_block_number = b.block_num();
-      dgp.head_block_id = b.id();
+      dgp.head_block_id = block_id;
       dgp.time = b.timestamp;
       dgp.current_aslot += missed_blocks+1;
    } );
@@ -3098,34 +3751,111 @@ void database::update_last_irreversible_block()
       }
    }
 
-   commit( dpo.last_irreversible_block_num );
+   uint32_t retain_above = dpo.last_irreversible_block_num;
+   bool write_block_log = !( get_node_properties().skip_flags & skip_block_log );
 
-   if( !( get_node_properties().skip_flags & skip_block_log ) )
-   {
-      // output to block log based on new last irreverisible block num
-      const auto& tmp_head = _block_log.head();
-      uint64_t log_head_num = 0;
+   // Undo history may only be discarded up to the last block the block log holds on disk, otherwise
+   // a crash would leave the state ahead of the log and open() could not find its head block
+   uint32_t commit_num = dpo.last_irreversible_block_num;
+   if( write_block_log )
+      commit_num = std::min< uint32_t >( commit_num, _block_log_durable_num );
 
-      if( tmp_head )
-         log_head_num = tmp_head->block_num();
+   // Reindex manages its own undo sessions when checkpointing
+   if( !( get_node_properties().skip_flags & skip_undo_block ) )
+      commit( commit_num );
 
-      if( log_head_num < dpo.last_irreversible_block_num )
+   if( write_block_log )
+   {
+      // hand newly irreversible blocks to the block log writer
+      if( _block_log_queued_num < dpo.last_irreversible_block_num )
       {
-         while( log_head_num < dpo.last_irreversible_block_num )
+         std::deque< signed_block_ptr > blocks;
+         while( _block_log_queued_num < dpo.last_irreversible_block_num )
          {
-            shared_ptr< fork_item > block = _fork_db.fetch_block_on_main_branch_by_number( log_head_num+1 );
+            shared_ptr< fork_item > block = _fork_db.fetch_block_on_main_branch_by_number( _block_log_queued_num+1 );
             FC_ASSERT( block, "Current fork in the fork database does not contain the last_irreversible_block" );
-            _block_log.append( block->data );
-            log_head_num++;
+            blocks.push_back( block->data );
+            _block_log_queued_num++;
          }
 
-         _block_log.flush();
+         {
+            std::lock_guard< std::mutex > lock( _block_log_queue_mutex );
+            _block_log_queue.insert( _block_log_queue.end(), blocks.begin(), blocks.end() );
+         }
+         if( !_block_log_paused )
+            _block_log_write = _block_log_thread->async( [this]() { write_queued_blocks(); } );
       }
+
+      // keep blocks that are not durable yet so they can still be fetched
+      retain_above = std::min< uint32_t >( retain_above, _block_log_durable_num );
    }
 
-   _fork_db.set_max_size( dpo.head_block_number - dpo.last_irreversible_block_num + 1 );
+   _fork_db.set_max_size( dpo.head_block_number - retain_above + 1 );
 } FC_CAPTURE_AND_RETHROW() }
 
+void database::write_queued_blocks()
+{
+   std::deque< signed_block_ptr > blocks;
+   {
+      std::lock_guard< std::mutex > lock( _block_log_queue_mutex );
+      blocks.swap( _block_log_queue );
+   }
+
+   bool failed = true;
+   try
+   {
+      for( const auto& b : blocks )
+         _block_log.append( *b );
+
+      _block_log.flush();
+      failed = false;
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Failed to write irreversible blocks to the block log, will retry: ${e}", ("e", e.to_detail_string()) );
+   }
+   catch( const std::exception& e )
+   {
+      elog( "Failed to write irreversible blocks to the block log, will retry: ${e}", ("e", e.what()) );
+   }
+   catch( ... )
+   {
+      elog( "Failed to write irreversible blocks to the block log, will retry" );
+   }
+
+   if( failed )
+   {
+      // A failed write may have left part of a block in the files. Cut them back to the last flush and
+      // put the whole batch back so the next write retries it first, nothing new is durable.
+      _block_log.discard_unflushed();
+
+      std::lock_guard< std::mutex > lock( _block_log_queue_mutex );
+      _block_log_queue.insert( _block_log_queue.begin(), blocks.begin(), blocks.end() );
+      return;
+   }
+
+   _block_log_durable_num = _block_log.head_num();
+}
+
+void database::pause_block_log_writes( bool paused )
+{
+   _block_log_paused = paused;
+
+   if( !paused && _block_log_thread )
+      _block_log_write = _block_log_thread->async( [this]() { write_queued_blocks(); } );
+}
+
+void database::flush_block_log()
+{
+   if( _block_log_write.valid() )
+      _block_log_write.wait();
+   _block_log_write = fc::future< void >();
+
+   // Anything left over from a failed write is retried here
+   if( _block_log_thread )
+      write_queued_blocks();
+}
+
 
 bool database::apply_order( const limit_order_object& new_order_object )
 {
@@ -3305,6 +4035,8 @@ void database::clear_expired_transactions()
    const auto& dedupe_index = transaction_idx.indices().get< by_expiration >();
    while( ( !dedupe_index.empty() ) && ( head_block_time() > dedupe_index.begin()->expiration ) )
       remove( *dedupe_index.begin() );
+
+   _signature_cache.remove_expired( head_block_time() );
 }
 
 void database::clear_expired_orders()
@@ -3572,6 +4304,14 @@ void database::init_hardforks()
    FC_ASSERT( hardforks.last_hardfork <= NUM_HARDFORKS, "Chain knows of more hardforks than configuration", ("hardforks.last_hardfork",hardforks.last_hardfork)("NUM_HARDFORKS",NUM_HARDFORKS) );
    FC_ASSERT( _hardfork_versions[ hardforks.last_hardfork ] <= BLOCKCHAIN_VERSION, "Blockchain version is older than last applied hardfork" );
    FC_ASSERT( BLOCKCHAIN_HARDFORK_VERSION == _hardfork_versions[ NUM_HARDFORKS ] );
+
+#ifdef ASSUMED_HARDFORK
+   static_assert( ASSUMED_HARDFORK <= NUM_HARDFORKS, "ASSUMED_HARDFORK is not a known hardfork" );
+   for( uint32_t i = 1; i <= ASSUMED_HARDFORK; ++i )
+      FC_ASSERT( _hardfork_times[ i ] <= GENESIS_TIME, "Assumed hardfork was not active at genesis", ("hardfork", i) );
+#endif
+
+   update_hardfork_cache();
 }
 
 void database::process_hardforks()
@@ -3606,9 +4346,10 @@ void database::process_hardforks()
    FC_CAPTURE_AND_RETHROW()
 }
 
-bool database::has_hardfork( uint32_t hardfork )const
+void database::update_hardfork_cache()
 {
-   return get_hardfork_property_object().processed_hardforks.size() > hardfork;
+   const auto* hardforks = find< hardfork_property_object >();
+   _processed_hardfork_count = hardforks ? uint32_t( hardforks->processed_hardforks.size() ) : 0;
 }
 
 void database::set_hardfork( uint32_t hardfork, bool apply_now )
@@ -3759,7 +4500,7 @@ void database::apply_hardfork( uint32_t hardfork )
             modify( get_feed_history(), [&]( feed_history_object& fho )
             {
                while( fho.price_history.size() > FEED_HISTORY_WINDOW )
-                  fho.price_history.pop_front();
+                  fho.pop_oldest_price();
             });
          }
          break;
@@ -3903,12 +4644,17 @@ void database::apply_hardfork( uint32_t hardfork )
       FC_ASSERT( hfp.processed_hardforks[ hfp.last_hardfork ] == _hardfork_times[ hfp.last_hardfork ], "Hardfork processing failed sanity check..." );
    } );
 
+   update_hardfork_cache();
+
    push_virtual_operation( hardfork_operation( hardfork ), true );
 }
 
 void database::retally_liquidity_weight() {
    const auto& ridx = get_index< liquidity_reward_balance_index >().indices().get< by_owner >();
    for( const auto& i : ridx ) {
+      if( i.weight == i.min_volume_weight() )
+         continue;
+
       modify( i, []( liquidity_reward_balance_object& o ){
          o.update_weight(true/*HAS HARDFORK10 if this method is called*/);
       });
@@ -3918,136 +4664,310 @@ void database::retally_liquidity_weight() {
 /**
  * Verifies all supply invariantes check out
  */
-void database::validate_invariants()const
-{
-   try
+namespace detail {
+
+   /**
+    * Partial sums and violations gathered by one partition of the invariant check.
+    */
+   struct invariant_totals
    {
-      const auto& account_idx = get_index<account_index>().indices().get<by_name>();
-      asset total_supply = asset( 0, SYMBOL_COIN );
-      asset TSDtotal = asset( 0, SYMBOL_USD );
-      asset totalSCORE = asset( 0, SYMBOL_SCORE );
-      asset pending_SCOREvalueInTME = asset( 0, SYMBOL_COIN );
-      share_type totalSCOREfundTMEbalance_votes = share_type( 0 );
+      asset       total_supply = asset( 0, SYMBOL_COIN );
+      asset       TSDtotal = asset( 0, SYMBOL_USD );
+      asset       totalSCORE = asset( 0, SYMBOL_SCORE );
+      asset       pending_SCOREvalueInTME = asset( 0, SYMBOL_COIN );
+      share_type  totalSCOREfundTMEbalance_votes = 0;
 
-      auto gpo = get_dynamic_global_properties();
+      /// Invariant description to the ids of (at most max_reported_ids) offending objects
+      std::map< std::string, std::vector< int64_t > > violations;
 
-      /// verify no witness has too many votes
-      const auto& witness_idx = get_index< witness_index >().indices();
-      for( auto itr = witness_idx.begin(); itr != witness_idx.end(); ++itr )
-         FC_ASSERT( itr->votes <= gpo.totalSCORE.amount, "", ("itr",*itr) );
+      static const size_t max_reported_ids = 16;
 
-      for( auto itr = account_idx.begin(); itr != account_idx.end(); ++itr )
+      void add_violation( const std::string& invariant, int64_t id )
       {
-         total_supply += itr->balance;
-         total_supply += itr->TMEsavingsBalance;
-         total_supply += itr->TMErewardBalance;
-         TSDtotal += itr->TSDbalance;
-         TSDtotal += itr->TSDsavingsBalance;
-         TSDtotal += itr->TSDrewardBalance;
-         totalSCORE += itr->SCORE;
-         totalSCORE += itr->SCORErewardBalance;
-         pending_SCOREvalueInTME += itr->SCORErewardBalanceInTME;
-         totalSCOREfundTMEbalance_votes += ( itr->proxy == PROXY_TO_SELF_ACCOUNT ?
-                                 itr->witness_vote_weight() :
-                                 ( MAX_PROXY_RECURSION_DEPTH > 0 ?
-                                      itr->proxied_SCOREfundTMEbalance_votes[MAX_PROXY_RECURSION_DEPTH - 1] :
-                                      itr->SCORE.amount ) );
-
+         auto& ids = violations[ invariant ];
+         if( ids.size() < max_reported_ids )
+            ids.push_back( id );
       }
 
-      const auto& convert_request_idx = get_index< convert_request_index >().indices();
-
-      for( auto itr = convert_request_idx.begin(); itr != convert_request_idx.end(); ++itr )
+      invariant_totals& operator += ( const invariant_totals& o )
       {
-         if( itr->amount.symbol == SYMBOL_COIN )
-            total_supply += itr->amount;
-         else if( itr->amount.symbol == SYMBOL_USD )
-            TSDtotal += itr->amount;
-         else
-            FC_ASSERT( false, "Encountered illegal symbol in convert_request_object" );
-      }
+         total_supply += o.total_supply;
+         TSDtotal += o.TSDtotal;
+         totalSCORE += o.totalSCORE;
+         pending_SCOREvalueInTME += o.pending_SCOREvalueInTME;
+         totalSCOREfundTMEbalance_votes += o.totalSCOREfundTMEbalance_votes;
 
-      const auto& limit_order_idx = get_index< limit_order_index >().indices();
+         for( const auto& v : o.violations )
+            for( auto id : v.second )
+               add_violation( v.first, id );
 
-      for( auto itr = limit_order_idx.begin(); itr != limit_order_idx.end(); ++itr )
-      {
-         if( itr->sell_price.base.symbol == SYMBOL_COIN )
-         {
-            total_supply += asset( itr->for_sale, SYMBOL_COIN );
-         }
-         else if ( itr->sell_price.base.symbol == SYMBOL_USD )
-         {
-            TSDtotal += asset( itr->for_sale, SYMBOL_USD );
-         }
+         return *this;
       }
+   };
+
+   /**
+    * The add_holdings overloads add the funds held by one object to the totals. Both the full
+    * invariant scan and the per block supply delta check sum holdings through these.
+    */
+   void add_holdings( invariant_totals& t, const account_object& a )
+   {
+      t.total_supply += a.balance;
+      t.total_supply += a.TMEsavingsBalance;
+      t.total_supply += a.TMErewardBalance;
+      t.TSDtotal += a.TSDbalance;
+      t.TSDtotal += a.TSDsavingsBalance;
+      t.TSDtotal += a.TSDrewardBalance;
+      t.totalSCORE += a.SCORE;
+      t.totalSCORE += a.SCORErewardBalance;
+      t.pending_SCOREvalueInTME += a.SCORErewardBalanceInTME;
+      t.totalSCOREfundTMEbalance_votes += ( a.proxy == PROXY_TO_SELF_ACCOUNT ?
+                              a.witness_vote_weight() :
+                              ( MAX_PROXY_RECURSION_DEPTH > 0 ?
+                                   a.proxied_SCOREfundTMEbalance_votes[MAX_PROXY_RECURSION_DEPTH - 1] :
+                                   a.SCORE.amount ) );
+   }
+
+   void add_holdings( invariant_totals& t, const convert_request_object& c )
+   {
+      if( c.amount.symbol == SYMBOL_COIN )
+         t.total_supply += c.amount;
+      else if( c.amount.symbol == SYMBOL_USD )
+         t.TSDtotal += c.amount;
+      else
+         t.add_violation( "illegal symbol in convert_request_object", c.id._id );
+   }
+
+   void add_holdings( invariant_totals& t, const limit_order_object& o )
+   {
+      if( o.sell_price.base.symbol == SYMBOL_COIN )
+         t.total_supply += asset( o.for_sale, SYMBOL_COIN );
+      else if ( o.sell_price.base.symbol == SYMBOL_USD )
+         t.TSDtotal += asset( o.for_sale, SYMBOL_USD );
+   }
+
+   void add_holdings( invariant_totals& t, const escrow_object& e )
+   {
+      t.total_supply += e.TMEbalance;
+      t.TSDtotal += e.TSDbalance;
 
-      const auto& escrow_idx = get_index< escrow_index >().indices().get< by_id >();
+      if( e.pending_fee.symbol == SYMBOL_COIN )
+         t.total_supply += e.pending_fee;
+      else if( e.pending_fee.symbol == SYMBOL_USD )
+         t.TSDtotal += e.pending_fee;
+      else
+         t.add_violation( "escrow pending fee that is not TSD or TME", e.id._id );
+   }
+
+   void add_holdings( invariant_totals& t, const savings_withdraw_object& w )
+   {
+      if( w.amount.symbol == SYMBOL_COIN )
+         t.total_supply += w.amount;
+      else if( w.amount.symbol == SYMBOL_USD )
+         t.TSDtotal += w.amount;
+      else
+         t.add_violation( "savings withdraw that is not TSD or TME", w.id._id );
+   }
+
+   void add_holdings( invariant_totals& t, const reward_fund_object& r )
+   {
+      t.total_supply += r.reward_balance;
+   }
+
+   void add_holdings( invariant_totals& t, const dynamic_global_property_object& gpo )
+   {
+      t.total_supply += gpo.totalTMEfundForSCORE + gpo.total_reward_fund_TME + gpo.pending_rewarded_SCOREvalueInTME;
+   }
+
+   /**
+    * Splits a by_id index into id ranges and, on the database thread pool, calls visit( partial, object )
+    * for every object with a default constructed partial result per range. Each partial is then passed
+    * to merge( result, partial ) one at a time. visit must not modify the database.
+    */
+   template< typename ByIdIndex, typename Result, typename Visit, typename Merge >
+   void reduce_partitioned( const database& db, const ByIdIndex& idx, Result& result, Visit visit, Merge merge )
+   {
+      if( idx.empty() )
+         return;
+
+      typedef typename ByIdIndex::value_type::id_type id_type;
+      int64_t min_id = idx.begin()->id._id;
+      int64_t max_id = idx.rbegin()->id._id;
+      std::mutex result_mutex;
 
-      for( auto itr = escrow_idx.begin(); itr != escrow_idx.end(); ++itr )
+      db.run_parallel( size_t( max_id - min_id + 1 ), [&]( size_t begin, size_t end )
       {
-         total_supply += itr->TMEbalance;
-         TSDtotal += itr->TSDbalance;
+         Result partial;
+         auto itr = idx.lower_bound( id_type( min_id + begin ) );
+         auto stop = idx.lower_bound( id_type( min_id + end ) );
 
-         if( itr->pending_fee.symbol == SYMBOL_COIN )
-            total_supply += itr->pending_fee;
-         else if( itr->pending_fee.symbol == SYMBOL_USD )
-            TSDtotal += itr->pending_fee;
-         else
-            FC_ASSERT( false, "found escrow pending fee that is not TSD or TME" );
-      }
+         for( ; itr != stop; ++itr )
+            visit( partial, *itr );
+
+         std::lock_guard< std::mutex > lock( result_mutex );
+         merge( result, partial );
+      });
+   }
+
+   /**
+    * Calls add_holdings for every object of a by_id index in parallel and adds the partial totals into totals.
+    */
+   template< typename ByIdIndex >
+   void sum_partitioned( const database& db, const ByIdIndex& idx, invariant_totals& totals )
+   {
+      typedef typename ByIdIndex::value_type value_type;
+      reduce_partitioned( db, idx, totals,
+         []( invariant_totals& partial, const value_type& o ) { add_holdings( partial, o ); },
+         []( invariant_totals& t, const invariant_totals& partial ) { t += partial; } );
+   }
+
+   /**
+    * Adds every (id, count) entry of from into into.
+    */
+   template< typename IdType, typename Count >
+   void merge_counts( std::map< IdType, Count >& into, const std::map< IdType, Count >& from )
+   {
+      for( const auto& entry : from )
+         into[ entry.first ] += entry.second;
+   }
 
-      const auto& savings_withdraw_idx = get_index< savings_withdraw_index >().indices().get< by_id >();
+   /**
+    * Sums the holdings of every object touched in the innermost undo session, as they were when the
+    * session started into before and as they are now into after. Returns false if no session is active.
+    */
+   template< typename MultiIndexType >
+   bool sum_session_holdings( const chainbase::generic_index< MultiIndexType >& idx, invariant_totals& before, invariant_totals& after )
+   {
+      const auto* state = idx.head_undo_state();
+      if( state == nullptr )
+         return false;
 
-      for( auto itr = savings_withdraw_idx.begin(); itr != savings_withdraw_idx.end(); ++itr )
+      for( const auto& item : state->old_values )
       {
-         if( itr->amount.symbol == SYMBOL_COIN )
-            total_supply += itr->amount;
-         else if( itr->amount.symbol == SYMBOL_USD )
-            TSDtotal += itr->amount;
-         else
-            FC_ASSERT( false, "found savings withdraw that is not TSD or TME" );
+         add_holdings( before, item.second );
+         add_holdings( after, *idx.find( item.first ) );
       }
-      fc::uint128_t totalSCOREreward2;
 
-      const auto& comment_idx = get_index< comment_index >().indices();
+      for( const auto& item : state->removed_values )
+         add_holdings( before, item.second );
+
+      for( const auto& id : state->new_ids )
+         add_holdings( after, *idx.find( id ) );
+
+      return true;
+   }
+
+} // detail
+
+void database::validate_invariants()const
+{
+   try
+   {
+      detail::invariant_totals totals;
+      auto gpo = get_dynamic_global_properties();
+
+      /// verify no witness has too many votes
+      const auto& witness_idx = get_index< witness_index >().indices().get< by_id >();
+      std::mutex witness_mutex;
 
-      for( auto itr = comment_idx.begin(); itr != comment_idx.end(); ++itr )
+      run_parallel( witness_idx.size() ? size_t( witness_idx.rbegin()->id._id + 1 ) : 0, [&]( size_t begin, size_t end )
       {
-         if( itr->net_SCOREreward.value > 0 )
+         auto itr = witness_idx.lower_bound( witness_id_type( begin ) );
+         auto stop = witness_idx.lower_bound( witness_id_type( end ) );
+
+         for( ; itr != stop; ++itr )
          {
-            auto delta = util::evaluate_reward_curve( itr->net_SCOREreward.value );
-            totalSCOREreward2 += delta;
+            if( itr->votes > gpo.totalSCORE.amount )
+            {
+               std::lock_guard< std::mutex > lock( witness_mutex );
+               totals.add_violation( "witness votes exceed totalSCORE", itr->id._id );
+            }
          }
-      }
+      });
+
+      detail::sum_partitioned( *this, get_index< account_index >().indices().get< by_id >(), totals );
+      detail::sum_partitioned( *this, get_index< convert_request_index >().indices().get< by_id >(), totals );
+      detail::sum_partitioned( *this, get_index< limit_order_index >().indices().get< by_id >(), totals );
+      detail::sum_partitioned( *this, get_index< escrow_index >().indices().get< by_id >(), totals );
+      detail::sum_partitioned( *this, get_index< savings_withdraw_index >().indices().get< by_id >(), totals );
 
       const auto& reward_idx = get_index< reward_fund_index, by_id >();
 
       for( auto itr = reward_idx.begin(); itr != reward_idx.end(); ++itr )
       {
-         total_supply += itr->reward_balance;
+         detail::add_holdings( totals, *itr );
       }
-      total_supply += gpo.totalTMEfundForSCORE + gpo.total_reward_fund_TME + gpo.pending_rewarded_SCOREvalueInTME;
+      detail::add_holdings( totals, gpo );
 
-      FC_ASSERT( gpo.current_supply == total_supply, "", ("gpo.current_supply",gpo.current_supply)("total_supply",total_supply) );
-      FC_ASSERT( gpo.current_TSD_supply == TSDtotal, "", ("gpo.current_TSD_supply",gpo.current_TSD_supply)("TSDtotal",TSDtotal) );
-      FC_ASSERT( gpo.totalSCORE + gpo.pending_rewarded_SCORE == totalSCORE, "", ("gpo.totalSCORE",gpo.totalSCORE)("totalSCORE",totalSCORE) );
-      FC_ASSERT( gpo.totalSCORE.amount == totalSCOREfundTMEbalance_votes, "", ("totalSCORE",gpo.totalSCORE)("totalSCOREfundTMEbalance_votes",totalSCOREfundTMEbalance_votes) );
-      FC_ASSERT( gpo.pending_rewarded_SCOREvalueInTME == pending_SCOREvalueInTME, "", ("pending_rewarded_SCOREvalueInTME",gpo.pending_rewarded_SCOREvalueInTME)("pending_SCOREvalueInTME", pending_SCOREvalueInTME));
+      FC_ASSERT( totals.violations.empty(), "Invariant violated by objects", ("violations", totals.violations) );
 
-      FC_ASSERT( gpo.virtual_supply >= gpo.current_supply );
+      FC_ASSERT( gpo.current_supply == totals.total_supply, "Invariant current_supply failed", ("gpo.current_supply",gpo.current_supply)("total_supply",totals.total_supply) );
+      FC_ASSERT( gpo.current_TSD_supply == totals.TSDtotal, "Invariant current_TSD_supply failed", ("gpo.current_TSD_supply",gpo.current_TSD_supply)("TSDtotal",totals.TSDtotal) );
+      FC_ASSERT( gpo.totalSCORE + gpo.pending_rewarded_SCORE == totals.totalSCORE, "Invariant totalSCORE failed", ("gpo.totalSCORE",gpo.totalSCORE)("totalSCORE",totals.totalSCORE) );
+      FC_ASSERT( gpo.totalSCORE.amount == totals.totalSCOREfundTMEbalance_votes, "Invariant witness vote weight failed", ("totalSCORE",gpo.totalSCORE)("totalSCOREfundTMEbalance_votes",totals.totalSCOREfundTMEbalance_votes) );
+      FC_ASSERT( gpo.pending_rewarded_SCOREvalueInTME == totals.pending_SCOREvalueInTME, "Invariant pending_rewarded_SCOREvalueInTME failed", ("pending_rewarded_SCOREvalueInTME",gpo.pending_rewarded_SCOREvalueInTME)("pending_SCOREvalueInTME", totals.pending_SCOREvalueInTME));
+
+      FC_ASSERT( gpo.virtual_supply >= gpo.current_supply, "Invariant virtual_supply >= current_supply failed" );
       if ( !get_feed_history().current_median_history.is_null() )
       {
          FC_ASSERT( gpo.current_TSD_supply * get_feed_history().current_median_history + gpo.current_supply
-            == gpo.virtual_supply, "", ("gpo.current_TSD_supply",gpo.current_TSD_supply)("get_feed_history().current_median_history",get_feed_history().current_median_history)("gpo.current_supply",gpo.current_supply)("gpo.virtual_supply",gpo.virtual_supply) );
+            == gpo.virtual_supply, "Invariant virtual_supply failed", ("gpo.current_TSD_supply",gpo.current_TSD_supply)("get_feed_history().current_median_history",get_feed_history().current_median_history)("gpo.current_supply",gpo.current_supply)("gpo.virtual_supply",gpo.virtual_supply) );
       }
    }
    FC_CAPTURE_LOG_AND_RETHROW( (head_block_num()) );
 }
 
+void database::validate_supply_delta()const
+{
+   try
+   {
+      detail::invariant_totals before;
+      detail::invariant_totals after;
+
+      const auto& gpo_idx = get_index< dynamic_global_property_index >();
+      if( !detail::sum_session_holdings( gpo_idx, before, after ) )
+         return;
+
+      detail::sum_session_holdings( get_index< account_index >(), before, after );
+      detail::sum_session_holdings( get_index< convert_request_index >(), before, after );
+      detail::sum_session_holdings( get_index< limit_order_index >(), before, after );
+      detail::sum_session_holdings( get_index< escrow_index >(), before, after );
+      detail::sum_session_holdings( get_index< savings_withdraw_index >(), before, after );
+      detail::sum_session_holdings( get_index< reward_fund_index >(), before, after );
+
+      FC_ASSERT( after.violations.empty(), "Invariant violated by objects", ("violations", after.violations) );
+
+      const auto& gpo = get_dynamic_global_properties();
+      const auto& gpo_changes = gpo_idx.head_undo_state()->old_values;
+      auto old_gpo_itr = gpo_changes.find( gpo.id );
+      const auto& old_gpo = old_gpo_itr != gpo_changes.end() ? old_gpo_itr->second : gpo;
+
+      FC_ASSERT( gpo.current_supply - old_gpo.current_supply == after.total_supply - before.total_supply,
+         "Invariant current_supply delta failed", ("supply_delta",gpo.current_supply - old_gpo.current_supply)("held_delta",after.total_supply - before.total_supply) );
+      FC_ASSERT( gpo.current_TSD_supply - old_gpo.current_TSD_supply == after.TSDtotal - before.TSDtotal,
+         "Invariant current_TSD_supply delta failed", ("supply_delta",gpo.current_TSD_supply - old_gpo.current_TSD_supply)("held_delta",after.TSDtotal - before.TSDtotal) );
+      FC_ASSERT( ( gpo.totalSCORE + gpo.pending_rewarded_SCORE ) - ( old_gpo.totalSCORE + old_gpo.pending_rewarded_SCORE ) == after.totalSCORE - before.totalSCORE,
+         "Invariant totalSCORE delta failed", ("held_delta",after.totalSCORE - before.totalSCORE) );
+      FC_ASSERT( gpo.totalSCORE.amount - old_gpo.totalSCORE.amount == after.totalSCOREfundTMEbalance_votes - before.totalSCOREfundTMEbalance_votes,
+         "Invariant witness vote weight delta failed", ("vote_delta",after.totalSCOREfundTMEbalance_votes - before.totalSCOREfundTMEbalance_votes) );
+      FC_ASSERT( gpo.pending_rewarded_SCOREvalueInTME - old_gpo.pending_rewarded_SCOREvalueInTME == after.pending_SCOREvalueInTME - before.pending_SCOREvalueInTME,
+         "Invariant pending_rewarded_SCOREvalueInTME delta failed", ("held_delta",after.pending_SCOREvalueInTME - before.pending_SCOREvalueInTME) );
+   }
+   FC_CAPTURE_LOG_AND_RETHROW( (head_block_num()) );
+}
+
+void database::set_invariant_audit_interval( uint32_t audit_blocks )
+{
+   _invariant_audit_blocks = audit_blocks;
+}
+
 void database::perform_SCORE_split( uint32_t magnitude )
 {
    try
    {
+      auto start = fc::time_point::now();
+      ilog( "Performing SCORE split of ${m} over ${a} accounts and ${c} comments",
+         ("m", magnitude)("a", get_index< account_index >().indices().size())("c", get_index< comment_index >().indices().size()) );
+
       modify( get_dynamic_global_properties(), [&]( dynamic_global_property_object& d )
       {
          d.totalSCORE.amount *= magnitude;
@@ -4088,6 +5008,7 @@ void database::perform_SCORE_split( uint32_t magnitude )
             adjust_SCOREreward2( c, 0, util::evaluate_reward_curve( c.net_SCOREreward.value ) );
       }
 
+      ilog( "Done SCORE split, elapsed time: ${t} sec", ("t", double( ( fc::time_point::now() - start ).count() ) / 1000000.0) );
    }
    FC_CAPTURE_AND_RETHROW()
 }
@@ -4095,34 +5016,25 @@ void database::perform_SCORE_split( uint32_t magnitude )
 void database::retally_comment_children()
 {
    const auto& cidx = get_index< comment_index >().indices();
+   auto start = fc::time_point::now();
+   ilog( "Retallying comment children over ${n} comments", ("n", cidx.size()) );
 
-   // Clear children counts
-   for( auto itr = cidx.begin(); itr != cidx.end(); ++itr )
-   {
-      modify( *itr, [&]( comment_object& c )
+   // Count the children of every comment from a read only scan, then write only the counts that differ
+   std::map< comment_id_type, uint32_t > children;
+   detail::reduce_partitioned( *this, cidx.get< by_id >(), children,
+      [&]( std::map< comment_id_type, uint32_t >& counts, const comment_object& c )
       {
-         c.children = 0;
-      });
-   }
+         if( c.parent_author == ROOT_POST_PARENT )
+            return;
 
-   for( auto itr = cidx.begin(); itr != cidx.end(); ++itr )
-   {
-      if( itr->parent_author != ROOT_POST_PARENT )
-      {
 // Low memory nodes only need immediate child count, full nodes track total children
 #ifdef IS_LOW_MEM
-         modify( get_comment( itr->parent_author, itr->parent_permlink ), [&]( comment_object& c )
-         {
-            c.children++;
-         });
+         ++counts[ get_comment( c.parent_author, c.parent_permlink ).id ];
 #else
-         const comment_object* parent = &get_comment( itr->parent_author, itr->parent_permlink );
+         const comment_object* parent = &get_comment( c.parent_author, c.parent_permlink );
          while( parent )
          {
-            modify( *parent, [&]( comment_object& c )
-            {
-               c.children++;
-            });
+            ++counts[ parent->id ];
 
             if( parent->parent_author != ROOT_POST_PARENT )
                parent = &get_comment( parent->parent_author, parent->parent_permlink );
@@ -4130,15 +5042,58 @@ void database::retally_comment_children()
                parent = nullptr;
          }
 #endif
+      },
+      detail::merge_counts< comment_id_type, uint32_t > );
+
+   uint32_t updated = 0;
+   for( auto itr = cidx.begin(); itr != cidx.end(); ++itr )
+   {
+      auto count = children.find( itr->id );
+      uint32_t new_children = count == children.end() ? 0 : count->second;
+
+      if( itr->children != new_children )
+      {
+         modify( *itr, [&]( comment_object& c )
+         {
+            c.children = new_children;
+         });
+         ++updated;
       }
    }
+
+   ilog( "Done retallying comment children, ${u} updated, elapsed time: ${t} sec",
+      ("u", updated)("t", double( ( fc::time_point::now() - start ).count() ) / 1000000.0) );
 }
 
 void database::retally_witness_votes()
 {
    const auto& witness_idx = get_index< witness_index >().indices();
+   const auto& account_idx = get_index< account_index >().indices();
+   const auto& vidx = get_index< witness_vote_index >().indices().get< by_account_witness >();
+   auto start = fc::time_point::now();
+   ilog( "Retallying witness votes over ${a} accounts and ${w} witnesses", ("a", account_idx.size())("w", witness_idx.size()) );
 
-   // Clear all witness votes
+   // Sum the vote weight each witness receives from a read only scan of all accounts
+   std::map< witness_id_type, share_type > votes;
+   detail::reduce_partitioned( *this, account_idx.get< by_id >(), votes,
+      [&]( std::map< witness_id_type, share_type >& sums, const account_object& a )
+      {
+         if( a.proxy != PROXY_TO_SELF_ACCOUNT )
+            return;
+
+         auto wit_itr = vidx.lower_bound( boost::make_tuple( a.id, witness_id_type() ) );
+         while( wit_itr != vidx.end() && wit_itr->account == a.id )
+         {
+            sums[ wit_itr->witness ] += a.witness_vote_weight();
+            ++wit_itr;
+         }
+      },
+      detail::merge_counts< witness_id_type, share_type > );
+
+   /**
+    * After clearing, every vote applied through adjust_witness_vote happens at the same virtual time, so applying
+    * the summed weight once yields the same votes, position and scheduled time as applying each vote in turn.
+    */
    for( auto itr = witness_idx.begin(); itr != witness_idx.end(); ++itr )
    {
       modify( *itr, [&]( witness_object& w )
@@ -4146,54 +5101,55 @@ void database::retally_witness_votes()
          w.votes = 0;
          w.virtual_position = 0;
       } );
-   }
 
-   const auto& account_idx = get_index< account_index >().indices();
-
-   // Apply all existing votes by account
-   for( auto itr = account_idx.begin(); itr != account_idx.end(); ++itr )
-   {
-      if( itr->proxy != PROXY_TO_SELF_ACCOUNT ) continue;
-
-      const auto& a = *itr;
-
-      const auto& vidx = get_index<witness_vote_index>().indices().get<by_account_witness>();
-      auto wit_itr = vidx.lower_bound( boost::make_tuple( a.id, witness_id_type() ) );
-      while( wit_itr != vidx.end() && wit_itr->account == a.id )
-      {
-         adjust_witness_vote( get(wit_itr->witness), a.witness_vote_weight() );
-         ++wit_itr;
-      }
+      auto sum = votes.find( itr->id );
+      if( sum != votes.end() )
+         adjust_witness_vote( *itr, sum->second );
    }
+
+   ilog( "Done retallying witness votes, elapsed time: ${t} sec", ("t", double( ( fc::time_point::now() - start ).count() ) / 1000000.0) );
 }
 
 void database::retally_witness_vote_counts( bool force )
 {
    const auto& account_idx = get_index< account_index >().indices();
+   const auto& vidx = get_index< witness_vote_index >().indices().get< by_account_witness >();
+   auto start = fc::time_point::now();
+   ilog( "Retallying witness vote counts over ${n} accounts", ("n", account_idx.size()) );
 
-   // Check all existing votes by account
-   for( auto itr = account_idx.begin(); itr != account_idx.end(); ++itr )
-   {
-      const auto& a = *itr;
-      uint16_t witnesses_voted_for = 0;
-      if( force || (a.proxy != PROXY_TO_SELF_ACCOUNT  ) )
-      {
-        const auto& vidx = get_index< witness_vote_index >().indices().get< by_account_witness >();
-        auto wit_itr = vidx.lower_bound( boost::make_tuple( a.id, witness_id_type() ) );
-        while( wit_itr != vidx.end() && wit_itr->account == a.id )
-        {
-           ++witnesses_voted_for;
-           ++wit_itr;
-        }
-      }
-      if( a.witnesses_voted_for != witnesses_voted_for )
+   // Check all existing votes by account, collecting only the accounts whose count changed
+   std::map< account_id_type, uint16_t > changed;
+   detail::reduce_partitioned( *this, account_idx.get< by_id >(), changed,
+      [&]( std::map< account_id_type, uint16_t >& counts, const account_object& a )
       {
-         modify( a, [&]( account_object& account )
+         uint16_t witnesses_voted_for = 0;
+         if( force || (a.proxy != PROXY_TO_SELF_ACCOUNT  ) )
          {
-            account.witnesses_voted_for = witnesses_voted_for;
-         } );
-      }
+            auto wit_itr = vidx.lower_bound( boost::make_tuple( a.id, witness_id_type() ) );
+            while( wit_itr != vidx.end() && wit_itr->account == a.id )
+            {
+               ++witnesses_voted_for;
+               ++wit_itr;
+            }
+         }
+         if( a.witnesses_voted_for != witnesses_voted_for )
+            counts[ a.id ] = witnesses_voted_for;
+      },
+      []( std::map< account_id_type, uint16_t >& into, const std::map< account_id_type, uint16_t >& from )
+      {
+         into.insert( from.begin(), from.end() );
+      } );
+
+   for( const auto& entry : changed )
+   {
+      modify( get( entry.first ), [&]( account_object& account )
+      {
+         account.witnesses_voted_for = entry.second;
+      } );
    }
+
+   ilog( "Done retallying witness vote counts, ${u} updated, elapsed time: ${t} sec",
+      ("u", changed.size())("t", double( ( fc::time_point::now() - start ).count() ) / 1000000.0) );
 }
 
 } } //TME::chain
@@ -11,6 +11,7 @@ void fork_database::reset()
 {
    _head.reset();
    _index.clear();
+   _unlinked_index.clear();
 }
 
 void fork_database::pop_block()
@@ -21,7 +22,7 @@ void fork_database::pop_block()
    _head = prev;
 }
 
-void     fork_database::start_block(signed_block b)
+void     fork_database::start_block(signed_block_ptr b)
 {
    auto item = std::make_shared<fork_item>(std::move(b));
    _index.insert(item);
@@ -29,21 +30,45 @@ void     fork_database::start_block(signed_block b)
 }
 
 /**
- * Pushes the block into the fork database and caches it if it doesn't link
- *
+ * Pushes the block into the fork database and caches it if it doesn't link.
+ * Any cached blocks building on it are linked in after it.
  */
-shared_ptr<fork_item>  fork_database::push_block(const signed_block& b)
+shared_ptr<fork_item>  fork_database::push_block(const signed_block_ptr& b)
 {
    auto item = std::make_shared<fork_item>(b);
    try {
       _push_block(item);
+      _push_next(item);
    }
    catch ( const unlinkable_block_exception& e )
    {
-      wlog( "Pushing block to fork database that failed to link: ${id}, ${num}", ("id",b.id())("num",b.block_num()) );
-      wlog( "Head: ${num}, ${id}", ("num",_head->data.block_num())("id",_head->data.id()) );
+      wlog( "Pushing block to fork database that failed to link: ${id}, ${num}", ("id",item->id)("num",item->num) );
+      wlog( "Head: ${num}, ${id}", ("num",_head->num)("id",_head->id) );
+
+      // Only buffer blocks that could still link ahead of the head
+      if( _max_unlinked && item->num > _head->num && item->num <= _head->num + MAX_BLOCK_REORDERING
+         && !is_buffered( item->id ) )
+      {
+         auto& by_num_idx = _unlinked_index.get<block_num>();
+         if( _unlinked_index.size() >= _max_unlinked && item->num >= (*std::prev( by_num_idx.end() ))->num )
+         {
+            // A full buffer keeps its blocks over one that is no closer to the head
+            ++_unlinked_stats.evicted;
+         }
+         else
+         {
+            while( _unlinked_index.size() >= _max_unlinked )
+            {
+               // Drop the furthest block, the one least likely to link soon
+               by_num_idx.erase( std::prev( by_num_idx.end() ) );
+               ++_unlinked_stats.evicted;
+            }
+
+            _unlinked_index.insert( item );
+            ++_unlinked_stats.buffered;
+         }
+      }
       throw;
-      _unlinked_index.insert( item );
    }
    return _head;
 }
@@ -85,12 +110,42 @@ void fork_database::_push_next( const item_ptr& new_item )
     {
        auto tmp = *itr;
        prev_idx.erase( itr );
-       _push_block( tmp );
+
+       try
+       {
+          _push_block( tmp );
+          ++_unlinked_stats.linked;
+          _push_next( tmp );
+       }
+       catch( const fc::exception& e )
+       {
+          // The parent is invalid or the block is too old, drop it. Blocks built on it are pruned with old blocks.
+          wlog( "Dropping buffered block ${id} that failed to link: ${e}", ("id",tmp->id)("e",e.to_string()) );
+       }
 
        itr = prev_idx.find( new_item->id );
     }
 }
 
+fork_database::unlinked_stats fork_database::get_unlinked_stats()const
+{
+   unlinked_stats result = _unlinked_stats;
+   result.size = _unlinked_index.size();
+   return result;
+}
+
+void fork_database::set_max_unlinked( uint32_t s )
+{
+   _max_unlinked = s;
+
+   auto& by_num_idx = _unlinked_index.get<block_num>();
+   while( _unlinked_index.size() > _max_unlinked )
+   {
+      by_num_idx.erase( std::prev( by_num_idx.end() ) );
+      ++_unlinked_stats.evicted;
+   }
+}
+
 void fork_database::set_max_size( uint32_t s )
 {
    _max_size = s;
@@ -125,12 +180,7 @@ void fork_database::set_max_size( uint32_t s )
 bool fork_database::is_known_block(const block_id_type& id)const
 {
    auto& index = _index.get<block_id>();
-   auto itr = index.find(id);
-   if( itr != index.end() )
-      return true;
-   auto& unlinked_index = _unlinked_index.get<block_id>();
-   auto unlinked_itr = unlinked_index.find(id);
-   return unlinked_itr != unlinked_index.end();
+   return index.find(id) != index.end();
 }
 
 item_ptr fork_database::fetch_block(const block_id_type& id)const
@@ -139,10 +189,21 @@ item_ptr fork_database::fetch_block(const block_id_type& id)const
    auto itr = index.find(id);
    if( itr != index.end() )
       return *itr;
+   return item_ptr();
+}
+
+bool fork_database::is_buffered(const block_id_type& id)const
+{
    auto& unlinked_index = _unlinked_index.get<block_id>();
-   auto unlinked_itr = unlinked_index.find(id);
-   if( unlinked_itr != unlinked_index.end() )
-      return *unlinked_itr;
+   return unlinked_index.find(id) != unlinked_index.end();
+}
+
+item_ptr fork_database::fetch_unlinked(const block_id_type& id)const
+{
+   auto& unlinked_index = _unlinked_index.get<block_id>();
+   auto itr = unlinked_index.find(id);
+   if( itr != unlinked_index.end() )
+      return *itr;
    return item_ptr();
 }
 
@@ -180,19 +241,19 @@ pair<fork_database::branch_type,fork_database::branch_type>
    auto second_branch = *second_branch_itr;
 
 
-   while( first_branch->data.block_num() > second_branch->data.block_num() )
+   while( first_branch->num > second_branch->num )
    {
       result.first.push_back(first_branch);
       first_branch = first_branch->prev.lock();
       FC_ASSERT(first_branch);
    }
-   while( second_branch->data.block_num() > first_branch->data.block_num() )
+   while( second_branch->num > first_branch->num )
    {
       result.second.push_back( second_branch );
       second_branch = second_branch->prev.lock();
       FC_ASSERT(second_branch);
    }
-   while( first_branch->data.previous != second_branch->data.previous )
+   while( first_branch->previous_id() != second_branch->previous_id() )
    {
       result.first.push_back(first_branch);
       result.second.push_back(second_branch);
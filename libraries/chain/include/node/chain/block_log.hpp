@@ -31,6 +31,8 @@ namespace node { namespace chain {
     *
     * The main file is the only file that needs to persist. The index file can be reconstructed during a
     * linear scan of the main file.
+    *
+    * Appends and reads may happen on different threads, open and close may not.
     */
 
    class block_log {
@@ -44,6 +46,12 @@ namespace node { namespace chain {
 
          uint64_t append( const signed_block& b );
          void flush();
+
+         /**
+          * Cuts both files back to where they ended at the last successful flush, dropping any partially
+          * written block. If that is not possible the log refuses further appends.
+          */
+         void discard_unflushed();
          std::pair< signed_block, uint64_t > read_block( uint64_t file_pos )const;
          optional< signed_block > read_block_by_num( uint32_t block_num )const;
 
@@ -52,7 +60,9 @@ namespace node { namespace chain {
           */
          uint64_t get_block_pos( uint32_t block_num ) const;
          signed_block read_head()const;
-         const optional< signed_block >& head()const;
+         optional< signed_block > head()const;
+         uint32_t head_num()const;        ///< 0 when the log is empty
+         block_id_type head_id()const;
 
          static const uint64_t npos = std::numeric_limits<uint64_t>::max();
 
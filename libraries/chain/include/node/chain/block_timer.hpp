@@ -0,0 +1,150 @@
+#pragma once
+#include <fc/time.hpp>
+#include <fc/optional.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <array>
+#include <deque>
+#include <mutex>
+
+namespace node { namespace chain {
+
+   /**
+    *  Breaks the time spent applying a block down into the stages of database::apply_block and the
+    *  operation types it evaluated. Each stage is charged the time since the previous mark, so timing
+    *  a block costs one clock read per stage and two per operation.
+    *
+    *  The last blocks are kept in a rolling window for percentiles. Marks are only made by the thread
+    *  applying blocks, get_stats() may be called from any thread.
+    */
+   class block_timer
+   {
+      public:
+         /// Stages of applying a block, in the order apply_block runs them
+         enum stage_type
+         {
+            stage_prepare = 0,         ///< serializing, validating and recovering signatures of transactions
+            stage_merkle,
+            stage_header,              ///< header, size and witness version checks
+            stage_transactions,
+            stage_global_properties,   ///< dynamic global properties, signing witness and block summary
+            stage_irreversible,
+            stage_expirations,         ///< expired transactions, orders and delegations
+            stage_witness_schedule,
+            stage_feeds,               ///< median feed and virtual supply
+            stage_funds,
+            stage_conversions,
+            stage_comment_cashout,
+            stage_SCORE_withdrawals,
+            stage_savings_withdraws,
+            stage_liquidity_reward,
+            stage_account_deadlines,   ///< account recovery, escrow ratification and declined voting rights
+            stage_hardforks,
+            stage_notify,              ///< applied block and changed object observers
+            stage_invariants,
+            stage_flush,
+            stage_count
+         };
+
+         struct stage_time
+         {
+            std::string       stage;
+            fc::microseconds  elapsed;
+         };
+
+         struct operation_time
+         {
+            std::string       operation;
+            uint32_t          count = 0;
+            fc::microseconds  elapsed;
+         };
+
+         /// The slowest stages and operation types of one block
+         struct block_report
+         {
+            uint32_t                        block_num = 0;
+            uint32_t                        transactions = 0;
+            fc::microseconds                total;
+            std::vector< stage_time >       stages;       ///< slowest first
+            std::vector< operation_time >   operations;   ///< slowest first
+         };
+
+         struct stage_percentiles
+         {
+            std::string       stage;
+            fc::microseconds  p50;
+            fc::microseconds  p90;
+            fc::microseconds  p99;
+            fc::microseconds  max;
+         };
+
+         struct timing_stats
+         {
+            uint32_t                          blocks = 0;        ///< blocks in the rolling window
+            uint64_t                          slow_blocks = 0;   ///< blocks over the threshold since startup
+            fc::microseconds                  slow_threshold;
+            std::vector< stage_percentiles >  stages;            ///< the whole block first, then each stage
+            fc::optional< block_report >      last_slow_block;
+         };
+
+         block_timer( size_t window = 1200, fc::microseconds slow_threshold = fc::milliseconds( 500 ) );
+
+         void start_block( uint32_t block_num );
+
+         /// Charges the time since the previous mark to stage
+         void mark( stage_type stage )
+         {
+            auto now = fc::time_point::now();
+            _current[ stage ] += ( now - _last_mark ).count();
+            _last_mark = now;
+         }
+
+         /// Adds the evaluation time of an operation to the block being applied, does nothing between blocks
+         void record_operation( int64_t which, fc::microseconds elapsed );
+
+         /**
+          *  Ends the block started by start_block and adds it to the rolling window.
+          *  Returns its report when it took longer than the slow block threshold.
+          */
+         fc::optional< block_report > finish_block( uint32_t transactions );
+
+         void set_slow_threshold( fc::microseconds slow_threshold );
+         void set_window( size_t window );
+
+         timing_stats get_stats()const;
+
+         static const char* stage_name( stage_type stage );
+
+      private:
+         typedef std::array< int64_t, stage_count > stage_array;
+
+         struct block_sample
+         {
+            int64_t      total;
+            stage_array  stages;
+         };
+
+         bool                 _in_block = false;
+         uint32_t             _block_num = 0;
+         fc::time_point       _block_start;
+         fc::time_point       _last_mark;
+         stage_array          _current;
+
+         /// Count and evaluation time of each operation type in the current block, indexed by operation tag
+         std::vector< std::pair< uint32_t, int64_t > >   _operations;
+
+         mutable std::mutex            _mutex;
+         std::deque< block_sample >    _window;
+         size_t                        _max_window;
+         fc::microseconds              _slow_threshold;
+         uint64_t                      _slow_blocks = 0;
+         fc::optional< block_report >  _last_slow_block;
+   };
+
+} } // node::chain
+
+FC_REFLECT( node::chain::block_timer::stage_time, (stage)(elapsed) )
+FC_REFLECT( node::chain::block_timer::operation_time, (operation)(count)(elapsed) )
+FC_REFLECT( node::chain::block_timer::block_report, (block_num)(transactions)(total)(stages)(operations) )
+FC_REFLECT( node::chain::block_timer::stage_percentiles, (stage)(p50)(p90)(p99)(max) )
+FC_REFLECT( node::chain::block_timer::timing_stats, (blocks)(slow_blocks)(slow_threshold)(stages)(last_slow_block) )
@@ -8,6 +8,11 @@
 #include <node/chain/fork_database.hpp>
 #include <node/chain/block_log.hpp>
 #include <node/chain/operation_notification.hpp>
+#include <node/chain/prepared_transaction.hpp>
+#include <node/chain/transaction_pool.hpp>
+#include <node/chain/signature_cache.hpp>
+#include <node/chain/block_timer.hpp>
+#include <node/chain/operation_profiler.hpp>
 
 #include <node/protocol/protocol.hpp>
 
@@ -15,8 +20,13 @@
 #include <fc/signals.hpp>
 
 #include <fc/log/logger.hpp>
+#include <fc/thread/thread.hpp>
 
+#include <atomic>
+#include <deque>
+#include <functional>
 #include <map>
+#include <mutex>
 
 namespace node { namespace chain {
 
@@ -26,6 +36,7 @@ namespace node { namespace chain {
    using node::protocol::asset;
    using node::protocol::asset_symbol_type;
    using node::protocol::price;
+   using node::protocol::public_key_type;
 
    class database_impl;
    class custom_operation_interpreter;
@@ -34,6 +45,17 @@ namespace node { namespace chain {
       struct comment_reward_context;
    }
 
+   /**
+    *  Time spent in one category of time driven end of block processing.
+    */
+   struct deadline_timing
+   {
+      std::string       category;
+      uint64_t          runs = 0;
+      fc::microseconds  total;
+      fc::microseconds  max;
+   };
+
    /**
     *   @class database
     *   @brief tracks the blockchain state in an extensible manner
@@ -65,7 +87,7 @@ namespace node { namespace chain {
             skip_witness_schedule_check = 1 << 9,  ///< used while reindexing
             skip_validate               = 1 << 10, ///< used prior to checkpoint, skips validate() call on transaction
             skip_validate_invariants    = 1 << 11, ///< used to skip database invariant check on block application
-            skip_undo_block             = 1 << 12, ///< used to skip undo db on reindex
+            skip_undo_block             = 1 << 12, ///< used on reindex -- undo state is not committed at the last irreversible block
             skip_block_log              = 1 << 13  ///< used to skip block logging on reindex
          };
 
@@ -84,8 +106,12 @@ namespace node { namespace chain {
           *
           * This method may be called after or instead of @ref database::open, and will rebuild the object graph by
           * replaying blockchain history. When this method exits successfully, the database will be open.
+          *
+          * @param checkpoint_interval If non-zero, the shared memory file is flushed and the replayed height is
+          * recorded every checkpoint_interval blocks. An interrupted reindex then resumes from the last checkpoint
+          * instead of replaying from genesis.
           */
-         void reindex( const fc::path& data_dir, const fc::path& shared_mem_dir, uint64_t shared_file_size = (1024l*1024l*1024l*8l) );
+         void reindex( const fc::path& data_dir, const fc::path& shared_mem_dir, uint64_t shared_file_size = (1024l*1024l*1024l*8l), uint32_t checkpoint_interval = 0 );
 
          /**
           * @brief wipe Delete database from disk, and potentially the raw chain as well.
@@ -110,6 +136,10 @@ namespace node { namespace chain {
          block_id_type              get_block_id_for_num( uint32_t block_num )const;
          optional<signed_block>     fetch_block_by_id( const block_id_type& id )const;
          optional<signed_block>     fetch_block_by_number( uint32_t num )const;
+
+         /// As fetch_block_by_id/number, sharing the fork database's copy instead of copying the block
+         signed_block_ptr           fetch_shared_block_by_id( const block_id_type& id )const;
+         signed_block_ptr           fetch_shared_block_by_number( uint32_t num )const;
          const signed_transaction   get_recent_transaction( const transaction_id_type& trx_id )const;
          std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
 
@@ -164,10 +194,12 @@ namespace node { namespace chain {
          bool                                   before_last_checkpoint()const;
 
          bool push_block( const signed_block& b, uint32_t skip = skip_nothing );
+         bool push_block( const signed_block_ptr& b, uint32_t skip = skip_nothing );
          void push_transaction( const signed_transaction& trx, uint32_t skip = skip_nothing );
          void _maybe_warn_multiple_production( uint32_t height )const;
-         bool _push_block( const signed_block& b );
+         bool _push_block( const signed_block_ptr& b );
          void _push_transaction( const signed_transaction& trx );
+         void _push_transaction( const prepared_transaction& trx );
 
          signed_block generate_block(
             const fc::time_point_sec when,
@@ -192,18 +224,67 @@ namespace node { namespace chain {
           */
          void notify_pre_apply_operation( operation_notification& note );
          void notify_post_apply_operation( const operation_notification& note );
-         inline const void push_virtual_operation( const operation& op, bool force = false ); // vops are not needed for low mem. Force will push them on low mem.
+
+         /**
+          *  Notifies subscribers of a virtual operation. When nothing listens for OpType, no
+          *  operation_notification is built at all. Force will push them on low mem.
+          */
+         template< typename OpType >
+         void push_virtual_operation( const OpType& op, bool force = false )
+         {
+            if( has_operation_subscribers( operation::tag< OpType >::value ) )
+               notify_virtual_operation( op, force );
+         }
+
          void notify_pre_apply_block( const signed_block& block );
          void notify_applied_block( const signed_block& block );
          void notify_on_pending_transaction( const signed_transaction& tx );
          void notify_on_pre_apply_transaction( const signed_transaction& tx );
          void notify_on_applied_transaction( const signed_transaction& tx );
 
+         typedef std::function< void( const operation_notification& ) > operation_handler;
+
          /**
-          *  This signal is emitted for plugins to process every operation after it has been fully applied.
+          *  Registers handler to be called before (pre_apply) or after every operation whose tag
+          *  (operation::which()) is op_tag has been applied. Notifications are dispatched through a per tag
+          *  table, so handlers are only called for the operation types they subscribed to.
           */
-         fc::signal<void(const operation_notification&)> pre_apply_operation;
-         fc::signal<void(const operation_notification&)> post_apply_operation;
+         void subscribe_operation( int64_t op_tag, const operation_handler& handler, bool pre_apply );
+
+         /**
+          *  Registers handler for every operation type.
+          */
+         void subscribe_all_operations( const operation_handler& handler, bool pre_apply );
+
+         /**
+          *  Registers a handler for a single operation type, called with the operation already extracted
+          *  from the notification, e.g. db.subscribe< vote_operation >( [&]( const vote_operation& op,
+          *  const operation_notification& note ){ ... }, true ).
+          */
+         template< typename OpType >
+         void subscribe( const std::function< void( const OpType&, const operation_notification& ) >& handler, bool pre_apply )
+         {
+            subscribe_operation( operation::tag< OpType >::value, [handler]( const operation_notification& note )
+            {
+               handler( note.op.get< OpType >(), note );
+            }, pre_apply );
+         }
+
+         /// True if any handler, typed, per tag, catch-all or deferrable, would see an operation with this tag
+         bool has_operation_subscribers( int64_t op_tag )const
+         {
+            return !_pre_apply_operation_handlers[ op_tag ].empty()
+               || !_post_apply_operation_handlers[ op_tag ].empty()
+               || !_deferrable_operation_handlers.empty();
+         }
+
+         /**
+          *  Registers an operation handler that depends only on the notification and the indexes it owns,
+          *  not on the rest of the chain state at the time of the operation. Such handlers are called
+          *  inline like subscribed operation handlers, but while notifications are deferred (see
+          *  set_deferred_notification_blocks) they are buffered and run in batches, one worker per handler.
+          */
+         void add_deferrable_operation_handler( const std::function< void( const operation_notification& ) >& handler, bool pre_apply );
 
          fc::signal<void(const signed_block&)>           pre_apply_block;
 
@@ -330,6 +411,29 @@ namespace node { namespace chain {
          void account_recovery_processing();
          void expire_escrow_ratification();
          void process_decline_voting_rights();
+
+         /**
+          *  Categories of time driven end of block processing, in the order _apply_block runs them.
+          */
+         enum deadline_category
+         {
+            deadline_transactions = 0,
+            deadline_orders,
+            deadline_delegations,
+            deadline_conversions,
+            deadline_comment_cashout,
+            deadline_SCORE_withdrawals,
+            deadline_savings_withdraws,
+            deadline_account_recovery,
+            deadline_escrow_ratification,
+            deadline_decline_voting_rights,
+            deadline_category_count
+         };
+
+         /**
+          *  Per category timing of end of block deadline processing since the database was constructed.
+          */
+         const vector< deadline_timing >& get_deadline_timings()const { return _deadline_timings; }
          void update_median_feed();
 
          asset get_liquidity_reward()const;
@@ -392,13 +496,33 @@ namespace node { namespace chain {
          void retally_liquidity_weight();
          void update_virtual_supply();
 
-         bool has_hardfork( uint32_t hardfork )const;
+         /**
+          *  Answered from a process local mirror of the processed hardfork count, which is refreshed whenever
+          *  hardforks are applied or undone. With ASSUMED_HARDFORK defined, every hardfork up to it resolves to
+          *  true at compile time so the branches it guards drop out.
+          */
+         bool has_hardfork( uint32_t hardfork )const
+         {
+#ifdef ASSUMED_HARDFORK
+            if( hardfork <= ASSUMED_HARDFORK )
+               return true;
+#endif
+            return _processed_hardfork_count > hardfork;
+         }
 
          /* For testing and debugging only. Given a hardfork
             with id N, applies all hardforks with id <= N */
          void set_hardfork( uint32_t hardfork, bool process_now = true );
 
          void validate_invariants()const;
+
+         /**
+          *  Checks that the supply recorded in the dynamic global properties changed by exactly as much as
+          *  the funds held by the objects touched in the current undo session. Cost is proportional to the
+          *  number of objects the session touched, so it is cheap enough to run on every block.
+          */
+         void validate_supply_delta()const;
+
          /**
           * @}
           */
@@ -406,8 +530,101 @@ namespace node { namespace chain {
          const std::string& get_json_schema() const;
 
          void set_flush_interval( uint32_t flush_blocks );
+
+         /**
+          *  Limits how many blocks that arrive ahead of their parent are buffered until it does, 0 disables
+          *  buffering.
+          */
+         void set_max_unlinked_blocks( uint32_t max_blocks );
+
+         /**
+          *  Blocks until every irreversible block handed to the block log writer has been written and flushed.
+          */
+         void flush_block_log();
+
+         /**
+          *  While paused, irreversible blocks are held in memory instead of written, e.g. while the block log
+          *  files are being copied. They can still be fetched and their undo history is kept. flush_block_log()
+          *  and close() write them regardless.
+          */
+         void pause_block_log_writes( bool paused );
+
+         /// The last block written and flushed to the block log
+         uint32_t get_block_log_durable_num()const { return _block_log_durable_num; }
+
+         /**
+          *  Runs validate_invariants() every audit_blocks blocks and logs any failure. 0 disables the audit.
+          */
+         void set_invariant_audit_interval( uint32_t audit_blocks );
          void show_free_memory( bool force );
 
+         /**
+          *  Sets the number of worker threads available for parallel work in the database. A size of 0
+          *  runs all such work on the calling thread.
+          */
+         void set_thread_pool_size( uint32_t num_threads );
+         uint32_t get_thread_pool_size()const { return _thread_pool.size(); }
+
+         /**
+          *  Splits [0, count) into contiguous ranges and calls f( begin, end ) for each range on the thread pool,
+          *  blocking until all of them are done. The calling thread does not yield while waiting, so this may be
+          *  used while holding a chainbase lock. The first exception thrown by f is rethrown.
+          */
+         void run_parallel( size_t count, const std::function< void( size_t, size_t ) >& f )const;
+
+         /**
+          *  Prepares every transaction in the block on the thread pool, validating them unless skip has
+          *  skip_validate and recovering signature keys unless it skips signature or authority checks.
+          *  Transactions that fail either step are left unmarked so the error is raised when they are applied.
+          */
+         vector< prepared_transaction > prepare_transactions( const signed_block& b, uint32_t skip );
+
+         /**
+          *  Same result as signed_block::calculate_merkle_root() from the transactions' merkle digests.
+          *  The lower levels of large trees are hashed on the thread pool.
+          */
+         checksum_type calculate_merkle_root( vector< digest_type > ids )const;
+         checksum_type calculate_merkle_root( const vector< prepared_transaction >& trxs )const;
+
+         /**
+          *  The stateless stage of push_transaction: serializes, validates and recovers the signature keys
+          *  of trx without touching the database, so it may run on any thread without holding a lock.
+          *  Throws if trx fails validation.
+          */
+         prepared_transaction prepare_transaction( const signed_transaction& trx, uint32_t skip = skip_nothing );
+
+         /**
+          *  The stateful stage of push_transaction: applies a transaction returned by prepare_transaction
+          *  to the pending state under the write lock.
+          */
+         void push_prepared_transaction( const prepared_transaction& trx, uint32_t skip = skip_nothing );
+
+         signature_cache& get_signature_cache() { return _signature_cache; }
+
+         /**
+          *  Per stage timing of the blocks applied recently, and the report of the last block slower than
+          *  its threshold. Slow blocks are also logged when they are applied.
+          */
+         block_timer& get_block_timer() { return _block_timer; }
+         const block_timer& get_block_timer()const { return _block_timer; }
+
+         /**
+          *  Per operation type evaluator counts, times and object changes since startup or the last reset.
+          *  Logged at the end of a reindex.
+          */
+         operation_profiler& get_operation_profiler() { return _operation_profiler; }
+         const operation_profiler& get_operation_profiler()const { return _operation_profiler; }
+
+         transaction_pool& get_transaction_pool() { return _pending_tx; }
+         const transaction_pool& get_transaction_pool()const { return _pending_tx; }
+
+         /**
+          *  While reindexing, buffer deferrable operation notifications and dispatch them every
+          *  notification_blocks blocks instead of inline. 0 disables deferral.
+          */
+         void set_deferred_notification_blocks( uint32_t notification_blocks );
+         void flush_deferred_operation_notifications();
+
 #ifdef IS_TEST_NET
          bool liquidity_rewards_enabled = true;
          bool skip_price_feed_limit_check = true;
@@ -423,21 +640,26 @@ namespace node { namespace chain {
          optional< chainbase::database::session > _pending_tx_session;
 
          void apply_block( const signed_block& next_block, uint32_t skip = skip_nothing );
-         void apply_transaction( const signed_transaction& trx, uint32_t skip = skip_nothing );
-         void _apply_block( const signed_block& next_block );
-         void _apply_transaction( const signed_transaction& trx );
+         /// Applies a fork database block in its own undo session, skipping checks it already passed
+         void apply_fork_item( fork_item& item, uint32_t skip );
+         void apply_transaction( const prepared_transaction& trx, uint32_t skip = skip_nothing );
+         void _apply_block( const signed_block& next_block, const block_id_type& next_block_id );
+         void _apply_transaction( const prepared_transaction& trx );
          void apply_operation( const operation& op );
+         void notify_operation_handlers( const operation_notification& note, bool pre_apply );
+         void notify_virtual_operation( const operation& op, bool force ); // vops are not needed for low mem.
+         void notify_deferrable_operation_handlers( const operation_notification& note, bool pre_apply );
 
 
          ///Steps involved in applying a new block
          ///@{
 
          const witness_object& validate_block_header( uint32_t skip, const signed_block& next_block )const;
-         void create_block_summary(const signed_block& next_block);
+         void create_block_summary( const signed_block& next_block, const block_id_type& next_block_id );
 
          void clear_null_account_balance();
 
-         void update_global_dynamic_data( const signed_block& b );
+         void update_global_dynamic_data( const signed_block& b, const block_id_type& block_id );
          void update_signing_witness(const witness_object& signing_witness, const signed_block& new_block);
          void update_last_irreversible_block();
          void clear_expired_transactions();
@@ -445,18 +667,30 @@ namespace node { namespace chain {
          void clear_expired_delegations();
          void process_header_extensions( const signed_block& next_block );
 
+         /// Runs one category of end of block deadline processing and records its timing
+         void run_deadline_processing( deadline_category category, void (database::*process)() );
+
          void init_hardforks();
          void process_hardforks();
          void apply_hardfork( uint32_t hardfork );
 
+         /// Reloads the hardfork mirror used by has_hardfork() from the hardfork property object
+         void update_hardfork_cache();
+
          ///@}
 
          std::unique_ptr< database_impl > _my;
 
-         vector< signed_transaction >  _pending_tx;
+         transaction_pool              _pending_tx;
+
+         /// Running totals over _pending_tx that tell _generate_block whether the pending state can become the block as is
+         uint64_t                      _pending_tx_size = 0;
+         uint32_t                      _pending_tx_skip_flags = 0; ///< union of the skip flags pending transactions were applied with
+         fc::time_point_sec            _pending_tx_min_expiration = fc::time_point_sec::maximum();
          fork_database                 _fork_db;
          fc::time_point_sec            _hardfork_times[ NUM_HARDFORKS + 1 ];
          protocol::hardfork_version    _hardfork_versions[ NUM_HARDFORKS + 1 ];
+         uint32_t                      _processed_hardfork_count = 0;
 
          block_log                     _block_log;
 
@@ -468,6 +702,14 @@ namespace node { namespace chain {
 
          transaction_id_type           _current_trx_id;
          uint32_t                      _current_block_num    = 0;
+
+         /// Transactions of the block being pushed, prepared before taking the write lock and consumed by _apply_block
+         block_id_type                    _prepared_block_id;
+         vector< prepared_transaction >   _prepared_block_transactions;
+         signature_cache                  _signature_cache;
+         block_timer                      _block_timer;
+         operation_profiler               _operation_profiler;
+
          uint16_t                      _current_trx_in_block = 0;
          uint16_t                      _current_op_in_trx    = 0;
          uint16_t                      _current_virtual_op   = 0;
@@ -480,9 +722,45 @@ namespace node { namespace chain {
          uint32_t                      _next_flush_block = 0;
 
          uint32_t                      _last_free_gb_printed = 0;
+         uint32_t                      _invariant_audit_blocks = 0;
+         vector< deadline_timing >     _deadline_timings;
+
+         std::vector< std::shared_ptr< fc::thread > >  _thread_pool;
+
+         /**
+          *  Irreversible blocks are appended to the block log on _block_log_thread. The fork database keeps
+          *  every block above _block_log_durable_num, so blocks in flight can still be fetched, and undo
+          *  history is only committed up to it. A failed write is requeued and does not advance it.
+          */
+         void write_queued_blocks();
+
+         std::shared_ptr< fc::thread >    _block_log_thread;
+         std::mutex                       _block_log_queue_mutex;
+         std::deque< signed_block_ptr >   _block_log_queue;
+         fc::future< void >               _block_log_write;
+         uint32_t                         _block_log_queued_num = 0;   ///< last block handed to the writer
+         std::atomic< uint32_t >          _block_log_durable_num{ 0 }; ///< last block written and flushed
+         std::atomic< bool >              _block_log_paused{ false };
+
+         struct deferrable_operation_handler
+         {
+            std::function< void( const operation_notification& ) > handler;
+            bool                                                     pre_apply = false;
+         };
+
+         /// Operation handlers indexed by operation tag
+         vector< vector< operation_handler > >    _pre_apply_operation_handlers;
+         vector< vector< operation_handler > >    _post_apply_operation_handlers;
+
+         vector< deferrable_operation_handler >   _deferrable_operation_handlers;
+         vector< deferred_operation_notification > _deferred_operation_notifications;
+         uint32_t                      _deferred_notification_blocks = 0;
+         bool                          _defer_operation_notifications = false;
 
          flat_map< std::string, std::shared_ptr< custom_operation_interpreter > >   _custom_operation_interpreters;
          std::string                       _json_schema;
    };
 
 } }
+
+FC_REFLECT( node::chain::deadline_timing, (category)(runs)(total)(max) )
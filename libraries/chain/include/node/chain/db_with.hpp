@@ -45,7 +45,7 @@ struct skip_flags_restorer
  */
 struct pending_transactions_restorer
 {
-   pending_transactions_restorer( database& db, std::vector<signed_transaction>&& pending_transactions )
+   pending_transactions_restorer( database& db, std::vector<prepared_transaction>&& pending_transactions )
       : _db(db), _pending_transactions( std::move(pending_transactions) )
    {
       _db.clear_pending();
@@ -65,38 +65,56 @@ struct pending_transactions_restorer
          }
       }
       _db._popped_tx.clear();
-      for( const signed_transaction& tx : _pending_transactions )
+      auto& pool = _db.get_transaction_pool();
+      for( const prepared_transaction& tx : _pending_transactions )
       {
+         // Expired transactions would fail to apply, drop them without applying
+         if( tx.get_transaction().expiration < _db.head_block_time() )
+         {
+            pool.record_expired();
+            continue;
+         }
+
+         // Transactions included in the new blocks are already applied, they neither count against the pool nor as rejected
+         if( _db.is_known_transaction( tx.id() ) )
+            continue;
+
+         // A full pool is not the transaction's fault, count it as rejected rather than invalid
+         if( !pool.has_capacity( tx ) )
+         {
+            pool.record_rejected();
+            continue;
+         }
+
          try
          {
-            if( !_db.is_known_transaction( tx.id() ) ) {
-               // since push_transaction() takes a signed_transaction,
-               // the operation_results field will be ignored.
-               _db._push_transaction( tx );
-            }
+            // since push_transaction() takes a signed_transaction,
+            // the operation_results field will be ignored.
+            _db._push_transaction( tx );
          }
          catch( const transaction_exception& e )
          {
+            pool.record_invalid();
             dlog( "Pending transaction became invalid after switching to block ${b} ${n} ${t}",
                ("b", _db.head_block_id())("n", _db.head_block_num())("t", _db.head_block_time()) );
             dlog( "The invalid transaction caused exception ${e}", ("e", e.to_detail_string()) );
-            dlog( "${t}", ("t", tx) );
+            dlog( "${t}", ("t", tx.get_transaction()) );
          }
          catch( const fc::exception& e )
          {
-
+            pool.record_invalid();
             /*
             dlog( "Pending transaction became invalid after switching to block ${b} ${n} ${t}",
                ("b", _db.head_block_id())("n", _db.head_block_num())("t", _db.head_block_time()) );
             dlog( "The invalid pending transaction caused exception ${e}", ("e", e.to_detail_string() ) );
-            dlog( "${t}", ("t", tx) );
+            dlog( "${t}", ("t", tx.get_transaction()) );
             */
          }
       }
    }
 
    database& _db;
-   std::vector< signed_transaction > _pending_transactions;
+   std::vector< prepared_transaction > _pending_transactions;
 };
 
 /**
@@ -126,7 +144,7 @@ void with_skip_flags(
 template< typename Lambda >
 void without_pending_transactions(
    database& db,
-   std::vector<signed_transaction>&& pending_transactions,
+   std::vector<prepared_transaction>&& pending_transactions,
    Lambda callback )
 {
     pending_transactions_restorer restorer( db, std::move(pending_transactions) );
@@ -15,12 +15,15 @@ namespace node { namespace chain {
    using node::protocol::signed_block;
    using node::protocol::block_id_type;
 
+   /// Blocks are immutable once received and shared between the fork database, block application and callers
+   typedef shared_ptr< const signed_block > signed_block_ptr;
+
    struct fork_item
    {
-      fork_item( signed_block d )
-      :num(d.block_num()),id(d.id()),data( std::move(d) ){}
+      fork_item( signed_block_ptr d )
+      :num(d->block_num()),id(d->id()),data( std::move(d) ){}
 
-      block_id_type previous_id()const { return data.previous; }
+      block_id_type previous_id()const { return data->previous; }
 
       weak_ptr< fork_item > prev;
       uint32_t              num;    // initialized in ctor
@@ -29,8 +32,14 @@ namespace node { namespace chain {
        * building on top of it.
        */
       bool                  invalid = false;
+      /**
+       * Set once the block has been applied on top of its parent. Applying it
+       * there again yields the same result, so its stateless and signature
+       * checks are skipped when a fork switch re-applies it.
+       */
+      bool                  applied = false;
       block_id_type         id;
-      signed_block          data;
+      signed_block_ptr      data;
    };
    typedef shared_ptr<fork_item> item_ptr;
 
@@ -44,6 +53,9 @@ namespace node { namespace chain {
     *
     *  Every time a block is pushed into the fork DB the
     *  block with the highest block_num will be returned.
+    *
+    *  Blocks that arrive before their parent are buffered, up to
+    *  a limit, and linked in as soon as the parent is pushed.
     */
    class fork_database
    {
@@ -52,20 +64,33 @@ namespace node { namespace chain {
          /// The maximum number of blocks that may be skipped in an out-of-order push
          const static int MAX_BLOCK_REORDERING = 1024;
 
+         struct unlinked_stats
+         {
+            uint64_t size = 0;
+            uint64_t buffered = 0;  ///< blocks buffered because their parent was unknown
+            uint64_t linked = 0;    ///< buffered blocks linked in once their parent arrived
+            uint64_t evicted = 0;   ///< blocks dropped or not buffered to stay within the limit
+         };
+
          fork_database();
          void reset();
 
-         void                             start_block(signed_block b);
+         void                             start_block(signed_block_ptr b);
          void                             remove(block_id_type b);
          void                             set_head(shared_ptr<fork_item> h);
+         /// Only blocks linked to the chain, buffered blocks have not been validated
          bool                             is_known_block(const block_id_type& id)const;
          shared_ptr<fork_item>            fetch_block(const block_id_type& id)const;
+
+         /// Blocks waiting in the unlinked buffer for their parent
+         bool                             is_buffered(const block_id_type& id)const;
+         shared_ptr<fork_item>            fetch_unlinked(const block_id_type& id)const;
          vector<item_ptr>                 fetch_block_by_number(uint32_t n)const;
 
          /**
           *  @return the new head block ( the longest fork )
           */
-         shared_ptr<fork_item>            push_block(const signed_block& b);
+         shared_ptr<fork_item>            push_block(const signed_block_ptr& b);
          shared_ptr<fork_item>            head()const { return _head; }
          void                             pop_block();
 
@@ -91,6 +116,10 @@ namespace node { namespace chain {
          > fork_multi_index_type;
 
          void set_max_size( uint32_t s );
+         /// Limits the blocks buffered while their parent is missing, 0 disables buffering
+         void set_max_unlinked( uint32_t s );
+
+         unlinked_stats get_unlinked_stats()const;
 
       private:
          /** @return a pointer to the newly pushed item */
@@ -98,6 +127,8 @@ namespace node { namespace chain {
          void _push_next(const item_ptr& newly_inserted);
 
          uint32_t                 _max_size = 1024;
+         uint32_t                 _max_unlinked = MAX_BLOCK_REORDERING;
+         unlinked_stats           _unlinked_stats;
 
          fork_multi_index_type    _unlinked_index;
          fork_multi_index_type    _index;
@@ -105,3 +136,5 @@ namespace node { namespace chain {
    };
 
 } } // node::chain
+
+FC_REFLECT( node::chain::fork_database::unlinked_stats, (size)(buffered)(linked)(evicted) )
@@ -8,6 +8,8 @@
 #include <boost/multi_index/composite_key.hpp>
 #include <boost/multiprecision/cpp_int.hpp>
 
+#include <algorithm>
+
 
 namespace node { namespace chain {
 
@@ -157,15 +159,37 @@ namespace node { namespace chain {
       public:
          template< typename Constructor, typename Allocator >
          feed_history_object( Constructor&& c, allocator< Allocator > a )
-            :price_history( a.get_segment_manager() )
+            :price_history( a.get_segment_manager() ), sorted_history( a.get_segment_manager() )
          {
             c( *this );
          }
 
+         /// appends a new median feed, keeping sorted_history in order
+         void push_price( const price& p )
+         {
+            price_history.push_back( p );
+            sorted_history.insert( std::upper_bound( sorted_history.begin(), sorted_history.end(), p ), p );
+         }
+
+         /// drops the oldest feed from both the history and the sorted view
+         void pop_oldest_price()
+         {
+            auto itr = std::lower_bound( sorted_history.begin(), sorted_history.end(), price_history.front() );
+            sorted_history.erase( itr );
+            price_history.pop_front();
+         }
+
+         /// median of price_history, read directly from the sorted view
+         const price& median_price()const
+         {
+            return sorted_history[ sorted_history.size() / 2 ];
+         }
+
          id_type                                   id;
 
          price                                     current_median_history; ///< the current median of the price history, used as the base for convert operations
          bip::deque< price, allocator< price > >   price_history; ///< tracks this last week of median_feed one per hour
+         bip::vector< price, allocator< price > >  sorted_history; ///< price_history in ascending order
    };
 
 
@@ -497,7 +521,7 @@ FC_REFLECT( node::chain::limit_order_object,
 CHAINBASE_SET_INDEX_TYPE( node::chain::limit_order_object, node::chain::limit_order_index )
 
 FC_REFLECT( node::chain::feed_history_object,
-             (id)(current_median_history)(price_history) )
+             (id)(current_median_history)(price_history)(sorted_history) )
 CHAINBASE_SET_INDEX_TYPE( node::chain::feed_history_object, node::chain::feed_history_index )
 
 FC_REFLECT( node::chain::convert_request_object,
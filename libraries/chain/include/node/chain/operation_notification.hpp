@@ -15,7 +15,39 @@ struct operation_notification
    uint32_t            trx_in_block = 0;
    uint16_t            op_in_trx = 0;
    uint64_t            virtual_op = 0;
+   fc::time_point_sec  timestamp;
    const operation&    op;
 };
 
+/**
+ * An owning copy of an operation_notification, buffered while plugin notifications are deferred.
+ */
+struct deferred_operation_notification
+{
+   deferred_operation_notification( const operation_notification& note, bool pre )
+      : op( note.op ), trx_id( note.trx_id ), block( note.block ), trx_in_block( note.trx_in_block ),
+        op_in_trx( note.op_in_trx ), virtual_op( note.virtual_op ), timestamp( note.timestamp ), pre_apply( pre ) {}
+
+   operation_notification get_notification()const
+   {
+      operation_notification note( op );
+      note.trx_id       = trx_id;
+      note.block        = block;
+      note.trx_in_block = trx_in_block;
+      note.op_in_trx    = op_in_trx;
+      note.virtual_op   = virtual_op;
+      note.timestamp    = timestamp;
+      return note;
+   }
+
+   operation           op;
+   transaction_id_type trx_id;
+   uint32_t            block = 0;
+   uint32_t            trx_in_block = 0;
+   uint16_t            op_in_trx = 0;
+   uint64_t            virtual_op = 0;
+   fc::time_point_sec  timestamp;
+   bool                pre_apply = false;
+};
+
 } }
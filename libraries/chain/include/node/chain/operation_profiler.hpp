@@ -0,0 +1,64 @@
+#pragma once
+#include <chainbase/chainbase.hpp>
+
+#include <fc/reflect/reflect.hpp>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace node { namespace chain {
+
+   /**
+    *  Totals of the evaluations of each operation type applied by database::apply_operation: how many
+    *  there were, how long they took and how many objects and undo bytes they produced. Only evaluations
+    *  that succeed are counted, whether they are in a block or the pending state.
+    *
+    *  The profiler is internally locked so it may be read and reset from API threads.
+    */
+   class operation_profiler
+   {
+      public:
+         struct operation_stats
+         {
+            std::string operation;
+            uint64_t    count = 0;
+            uint64_t    total_ns = 0;
+            uint64_t    avg_ns = 0;
+            uint64_t    max_ns = 0;
+            uint64_t    created = 0;
+            uint64_t    modified = 0;
+            uint64_t    removed = 0;
+            uint64_t    undo_bytes = 0;
+         };
+
+         typedef chainbase::database::change_counters change_counters;
+
+         /// Adds an evaluation of the operation with tag which, given the database counters around it
+         void record( int64_t which, int64_t elapsed_ns, const change_counters& before, const change_counters& after );
+
+         /// Every operation type evaluated since the last reset, most total time first
+         std::vector< operation_stats > get_stats()const;
+
+         void reset();
+
+      private:
+         struct counters
+         {
+            uint64_t    count = 0;
+            uint64_t    total_ns = 0;
+            uint64_t    max_ns = 0;
+            uint64_t    created = 0;
+            uint64_t    modified = 0;
+            uint64_t    removed = 0;
+            uint64_t    undo_bytes = 0;
+         };
+
+         mutable std::mutex        _mutex;
+         std::vector< counters >   _operations;   ///< indexed by operation tag
+   };
+
+} } // node::chain
+
+FC_REFLECT( node::chain::operation_profiler::operation_stats,
+   (operation)(count)(total_ns)(avg_ns)(max_ns)(created)(modified)(removed)(undo_bytes) )
@@ -0,0 +1,69 @@
+#pragma once
+#include <node/protocol/transaction.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <cstring>
+
+namespace node { namespace chain {
+
+   using node::protocol::signed_transaction;
+   using node::protocol::transaction_id_type;
+   using node::protocol::digest_type;
+   using node::protocol::chain_id_type;
+   using node::protocol::public_key_type;
+
+   /**
+    *  A signed transaction together with the values derived from its serialization: the packed
+    *  bytes, id, signature digest and merkle digest. They are computed from a single serialization when the
+    *  transaction is prepared and reused by push, block production and block application.
+    */
+   class prepared_transaction
+   {
+      public:
+         prepared_transaction( const signed_transaction& trx, const chain_id_type& chain_id )
+            : _trx( trx )
+         {
+            _packed = fc::raw::pack( _trx );
+
+            // A packed signed_transaction is the packed transaction followed by its signatures
+            size_t trx_size = _packed.size() - fc::raw::pack_size( _trx.signatures );
+
+            digest_type::encoder enc;
+            enc.write( _packed.data(), trx_size );
+            auto h = enc.result();
+            memcpy( _id._hash, h._hash, std::min( sizeof( _id ), sizeof( h ) ) );
+
+            digest_type::encoder sig_enc;
+            fc::raw::pack( sig_enc, chain_id );
+            sig_enc.write( _packed.data(), trx_size );
+            _sig_digest = sig_enc.result();
+
+            // signed_transaction::merkle_digest() is the hash of the whole packed transaction
+            digest_type::encoder merkle_enc;
+            merkle_enc.write( _packed.data(), _packed.size() );
+            _merkle_digest = merkle_enc.result();
+         }
+
+         const signed_transaction&  get_transaction()const { return _trx; }
+         const transaction_id_type& id()const              { return _id; }
+         const digest_type&         sig_digest()const      { return _sig_digest; }
+         const digest_type&         merkle_digest()const   { return _merkle_digest; }
+         const vector< char >&      packed()const          { return _packed; }
+         size_t                     packed_size()const     { return _packed.size(); }
+
+         /// Signature keys, when they have been recovered ahead of application
+         optional< flat_set< public_key_type > > signature_keys;
+
+         /// Set once the stateless checks of signed_transaction::validate() have passed
+         bool validated = false;
+
+      private:
+         signed_transaction   _trx;
+         transaction_id_type  _id;
+         digest_type          _sig_digest;
+         digest_type          _merkle_digest;
+         vector< char >       _packed;
+   };
+
+} } // node::chain
@@ -0,0 +1,81 @@
+#pragma once
+#include <node/chain/prepared_transaction.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+
+#include <mutex>
+
+namespace node { namespace chain {
+   using boost::multi_index_container;
+   using namespace boost::multi_index;
+
+   using node::protocol::signed_transaction;
+   using node::protocol::public_key_type;
+   using node::protocol::chain_id_type;
+
+   /**
+    *  Caches the public keys recovered from transaction signatures so that a transaction
+    *  which is pushed, re-applied while producing and then received in a block is only
+    *  recovered once. Entries are keyed by a hash of the transaction id and its signatures
+    *  and are dropped when the transaction expires, or earliest-expiring first once the
+    *  cache is full.
+    *
+    *  The cache is internally locked and may be used from worker threads.
+    */
+   class signature_cache
+   {
+      public:
+         struct cache_stats
+         {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t evictions = 0;
+            uint64_t size = 0;
+         };
+
+         signature_cache( size_t max_size = 200000 );
+
+         /**
+          *  Returns the signature keys of trx, recovering and caching them on a miss.
+          *  Throws the same exceptions as signed_transaction::get_signature_keys().
+          */
+         flat_set< public_key_type > get_signature_keys( const prepared_transaction& trx );
+         flat_set< public_key_type > get_signature_keys( const signed_transaction& trx, const chain_id_type& chain_id );
+
+         void remove_expired( fc::time_point_sec now );
+         void set_max_size( size_t max_size );
+         void clear();
+
+         cache_stats get_stats()const;
+
+      private:
+         struct cache_entry
+         {
+            fc::sha256                    key;
+            fc::time_point_sec            expiration;
+            flat_set< public_key_type >   keys;
+         };
+
+         struct by_key;
+         struct by_expiration;
+
+         typedef multi_index_container<
+            cache_entry,
+            indexed_by<
+               hashed_unique< tag< by_key >, member< cache_entry, fc::sha256, &cache_entry::key >, std::hash< fc::sha256 > >,
+               ordered_non_unique< tag< by_expiration >, member< cache_entry, fc::time_point_sec, &cache_entry::expiration > >
+            >
+         > cache_index;
+
+         mutable std::mutex   _mutex;
+         cache_index          _entries;
+         size_t               _max_size;
+         cache_stats          _stats;
+   };
+
+} } // node::chain
+
+FC_REFLECT( node::chain::signature_cache::cache_stats, (hits)(misses)(evictions)(size) )
@@ -0,0 +1,125 @@
+#pragma once
+#include <node/chain/prepared_transaction.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/composite_key.hpp>
+
+namespace node { namespace chain {
+   using boost::multi_index_container;
+   using namespace boost::multi_index;
+
+   using node::protocol::account_name_type;
+   using node::protocol::authority;
+
+   /**
+    *  The pending transactions of the database, in the order they were accepted. Every transaction in the
+    *  pool has been applied to the pending state, so the pool only bounds how much is accepted: a transaction
+    *  is rejected when the pool or its account's queue is full. Expired transactions are dropped without
+    *  being applied when the pending state is rebuilt after a block.
+    *
+    *  The pool is owned by the database and is only used under its write lock.
+    */
+   class transaction_pool
+   {
+      public:
+         struct pool_stats
+         {
+            uint64_t size = 0;
+            uint64_t bytes = 0;
+            uint64_t accepted = 0;  ///< transactions added, including re-adds after a block
+            uint64_t rejected = 0;  ///< transactions refused because a limit was reached
+            uint64_t expired = 0;   ///< transactions dropped because they expired before being included
+            uint64_t invalid = 0;   ///< transactions dropped because they no longer applied after a block
+         };
+
+         transaction_pool( size_t max_count = 10000, size_t max_bytes = 64*1024*1024, size_t max_per_account = 1000 );
+
+         /**
+          *  Throws if adding trx would exceed a limit. Called before the transaction is applied so a rejected
+          *  transaction leaves no trace in the pending state.
+          */
+         void check_capacity( const prepared_transaction& trx );
+
+         /// Whether trx would fit, without counting a rejection
+         bool has_capacity( const prepared_transaction& trx )const;
+
+         /// Adds a transaction that has been applied to the pending state, returns false if it already is in the pool
+         bool push( const prepared_transaction& trx );
+
+         bool contains( const transaction_id_type& id )const;
+
+         /// Removes and returns every transaction in the order they were accepted
+         vector< prepared_transaction > take_all();
+
+         /**
+          *  Calls f for every transaction in the order they were accepted.
+          */
+         template< typename Lambda >
+         void for_each( Lambda f )const
+         {
+            for( const auto& e : _entries.get< by_sequence >() )
+               f( e.trx );
+         }
+
+         size_t size()const { return _entries.size(); }
+         bool empty()const { return _entries.empty(); }
+         void clear();
+
+         void set_limits( size_t max_count, size_t max_bytes, size_t max_per_account );
+
+         void record_expired() { ++_stats.expired; }
+         void record_rejected() { ++_stats.rejected; }
+         void record_invalid() { ++_stats.invalid; }
+
+         pool_stats get_stats()const;
+
+      private:
+         struct pool_entry
+         {
+            pool_entry( const prepared_transaction& t, uint64_t s, const account_name_type& a )
+               : trx( t ), id( t.id() ), sequence( s ), account( a ) {}
+
+            prepared_transaction trx;
+            transaction_id_type  id;
+            uint64_t             sequence;
+            account_name_type    account;
+         };
+
+         struct by_id;
+         struct by_sequence;
+         struct by_account;
+
+         typedef multi_index_container<
+            pool_entry,
+            indexed_by<
+               hashed_unique< tag< by_id >, member< pool_entry, transaction_id_type, &pool_entry::id >, std::hash< transaction_id_type > >,
+               ordered_unique< tag< by_sequence >, member< pool_entry, uint64_t, &pool_entry::sequence > >,
+               ordered_unique< tag< by_account >,
+                  composite_key< pool_entry,
+                     member< pool_entry, account_name_type, &pool_entry::account >,
+                     member< pool_entry, uint64_t, &pool_entry::sequence >
+                  >
+               >
+            >
+         > pool_index;
+
+         /// The account whose queue a transaction is counted against, the first account whose authority it requires
+         static account_name_type queue_account( const prepared_transaction& trx );
+
+         size_t account_queue_size( const account_name_type& account )const;
+
+         pool_index  _entries;
+         uint64_t    _next_sequence = 0;
+         uint64_t    _bytes = 0;
+         size_t      _max_count;
+         size_t      _max_bytes;
+         size_t      _max_per_account;
+         pool_stats  _stats;
+   };
+
+} } // node::chain
+
+FC_REFLECT( node::chain::transaction_pool::pool_stats, (size)(bytes)(accepted)(rejected)(expired)(invalid) )
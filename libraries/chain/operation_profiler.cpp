@@ -0,0 +1,68 @@
+#include <node/chain/operation_profiler.hpp>
+
+#include <node/protocol/operations.hpp>
+#include <node/protocol/operation_util_impl.hpp>
+
+#include <algorithm>
+
+namespace node { namespace chain {
+
+void operation_profiler::record( int64_t which, int64_t elapsed_ns, const change_counters& before, const change_counters& after )
+{
+   std::lock_guard< std::mutex > lock( _mutex );
+
+   if( size_t( which ) >= _operations.size() )
+      _operations.resize( which + 1 );
+
+   auto& c = _operations[ which ];
+   ++c.count;
+   c.total_ns += elapsed_ns;
+   c.max_ns = std::max< uint64_t >( c.max_ns, elapsed_ns );
+   c.created += after.created - before.created;
+   c.modified += after.modified - before.modified;
+   c.removed += after.removed - before.removed;
+   c.undo_bytes += after.undo_bytes - before.undo_bytes;
+}
+
+std::vector< operation_profiler::operation_stats > operation_profiler::get_stats()const
+{
+   std::vector< operation_stats > result;
+
+   {
+      std::lock_guard< std::mutex > lock( _mutex );
+      for( size_t i = 0; i < _operations.size(); i++ )
+      {
+         const auto& c = _operations[i];
+         if( c.count == 0 )
+            continue;
+
+         operation_stats s;
+         node::protocol::operation op;
+         op.set_which( i );
+         op.visit( fc::get_operation_name( s.operation ) );
+         s.count = c.count;
+         s.total_ns = c.total_ns;
+         s.avg_ns = c.total_ns / c.count;
+         s.max_ns = c.max_ns;
+         s.created = c.created;
+         s.modified = c.modified;
+         s.removed = c.removed;
+         s.undo_bytes = c.undo_bytes;
+         result.push_back( s );
+      }
+   }
+
+   std::sort( result.begin(), result.end(), []( const operation_stats& a, const operation_stats& b )
+   {
+      return a.total_ns > b.total_ns;
+   });
+   return result;
+}
+
+void operation_profiler::reset()
+{
+   std::lock_guard< std::mutex > lock( _mutex );
+   _operations.clear();
+}
+
+} } // node::chain
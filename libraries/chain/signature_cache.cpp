@@ -0,0 +1,90 @@
+#include <node/chain/signature_cache.hpp>
+
+#include <fc/io/raw.hpp>
+
+namespace node { namespace chain {
+
+signature_cache::signature_cache( size_t max_size )
+   : _max_size( max_size ) {}
+
+flat_set< public_key_type > signature_cache::get_signature_keys( const signed_transaction& trx, const chain_id_type& chain_id )
+{
+   return get_signature_keys( prepared_transaction( trx, chain_id ) );
+}
+
+flat_set< public_key_type > signature_cache::get_signature_keys( const prepared_transaction& trx )
+{
+   fc::sha256::encoder enc;
+   fc::raw::pack( enc, trx.id() );
+   fc::raw::pack( enc, trx.get_transaction().signatures );
+   fc::sha256 key = enc.result();
+
+   {
+      std::lock_guard< std::mutex > lock( _mutex );
+      auto itr = _entries.find( key );
+      if( itr != _entries.end() )
+      {
+         ++_stats.hits;
+         return itr->keys;
+      }
+      ++_stats.misses;
+   }
+
+   // Recover without holding the lock so workers can recover in parallel
+   auto keys = trx.get_transaction().get_signature_keys_for_digest( trx.sig_digest() );
+
+   std::lock_guard< std::mutex > lock( _mutex );
+   if( _max_size == 0 )
+      return keys;
+
+   auto& exp_idx = _entries.get< by_expiration >();
+   while( _entries.size() >= _max_size )
+   {
+      exp_idx.erase( exp_idx.begin() );
+      ++_stats.evictions;
+   }
+
+   cache_entry e;
+   e.key = key;
+   e.expiration = trx.get_transaction().expiration;
+   e.keys = keys;
+   _entries.insert( std::move( e ) );
+
+   return keys;
+}
+
+void signature_cache::remove_expired( fc::time_point_sec now )
+{
+   std::lock_guard< std::mutex > lock( _mutex );
+   auto& exp_idx = _entries.get< by_expiration >();
+   exp_idx.erase( exp_idx.begin(), exp_idx.upper_bound( now ) );
+}
+
+void signature_cache::set_max_size( size_t max_size )
+{
+   std::lock_guard< std::mutex > lock( _mutex );
+   _max_size = max_size;
+
+   auto& exp_idx = _entries.get< by_expiration >();
+   while( _entries.size() > _max_size )
+   {
+      exp_idx.erase( exp_idx.begin() );
+      ++_stats.evictions;
+   }
+}
+
+void signature_cache::clear()
+{
+   std::lock_guard< std::mutex > lock( _mutex );
+   _entries.clear();
+}
+
+signature_cache::cache_stats signature_cache::get_stats()const
+{
+   std::lock_guard< std::mutex > lock( _mutex );
+   cache_stats result = _stats;
+   result.size = _entries.size();
+   return result;
+}
+
+} } // node::chain
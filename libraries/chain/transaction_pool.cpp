@@ -0,0 +1,106 @@
+#include <node/chain/transaction_pool.hpp>
+
+#include <fc/exception/exception.hpp>
+
+namespace node { namespace chain {
+
+transaction_pool::transaction_pool( size_t max_count, size_t max_bytes, size_t max_per_account )
+   : _max_count( max_count ), _max_bytes( max_bytes ), _max_per_account( max_per_account ) {}
+
+account_name_type transaction_pool::queue_account( const prepared_transaction& trx )
+{
+   flat_set< account_name_type > active, owner, posting;
+   vector< authority > other;
+   trx.get_transaction().get_required_authorities( active, owner, posting, other );
+
+   if( active.size() )
+      return *active.begin();
+   if( owner.size() )
+      return *owner.begin();
+   if( posting.size() )
+      return *posting.begin();
+   return account_name_type();
+}
+
+size_t transaction_pool::account_queue_size( const account_name_type& account )const
+{
+   const auto& acc_idx = _entries.get< by_account >();
+   auto itr = acc_idx.lower_bound( boost::make_tuple( account ) );
+   auto end = acc_idx.upper_bound( boost::make_tuple( account ) );
+   return std::distance( itr, end );
+}
+
+void transaction_pool::check_capacity( const prepared_transaction& trx )
+{
+   try
+   {
+      FC_ASSERT( _entries.size() < _max_count, "Pending transaction pool is full", ("max", _max_count) );
+      FC_ASSERT( _bytes + trx.packed_size() <= _max_bytes, "Pending transaction pool is out of space", ("max_bytes", _max_bytes) );
+
+      auto account = queue_account( trx );
+      FC_ASSERT( account_queue_size( account ) < _max_per_account,
+         "Account has too many pending transactions", ("account", account)("max", _max_per_account) );
+   }
+   catch( const fc::exception& )
+   {
+      ++_stats.rejected;
+      throw;
+   }
+}
+
+bool transaction_pool::has_capacity( const prepared_transaction& trx )const
+{
+   return _entries.size() < _max_count
+      && _bytes + trx.packed_size() <= _max_bytes
+      && account_queue_size( queue_account( trx ) ) < _max_per_account;
+}
+
+bool transaction_pool::push( const prepared_transaction& trx )
+{
+   if( !_entries.insert( pool_entry( trx, _next_sequence++, queue_account( trx ) ) ).second )
+      return false;
+
+   _bytes += trx.packed_size();
+   ++_stats.accepted;
+   return true;
+}
+
+bool transaction_pool::contains( const transaction_id_type& id )const
+{
+   return _entries.find( id ) != _entries.end();
+}
+
+vector< prepared_transaction > transaction_pool::take_all()
+{
+   vector< prepared_transaction > result;
+   result.reserve( _entries.size() );
+
+   for( const auto& e : _entries.get< by_sequence >() )
+      result.push_back( e.trx );
+
+   clear();
+   return result;
+}
+
+void transaction_pool::clear()
+{
+   _entries.clear();
+   _bytes = 0;
+}
+
+void transaction_pool::set_limits( size_t max_count, size_t max_bytes, size_t max_per_account )
+{
+   _max_count = max_count;
+   _max_bytes = max_bytes;
+   _max_per_account = max_per_account;
+}
+
+transaction_pool::pool_stats transaction_pool::get_stats()const
+{
+   pool_stats result = _stats;
+   result.size = _entries.size();
+   result.bytes = _bytes;
+   return result;
+}
+
+} } // node::chain
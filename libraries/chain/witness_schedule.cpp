@@ -38,26 +38,26 @@ void update_median_witness_props( database& db )
       active.push_back( &db.get_witness( wso.current_shuffled_witnesses[i] ) );
    }
 
-   /// sort them by account_creation_fee
-   std::sort( active.begin(), active.end(), [&]( const witness_object* a, const witness_object* b )
+   /// only the median element is needed for each property, so partially sort around it
+   auto median = active.begin() + active.size()/2;
+
+   std::nth_element( active.begin(), median, active.end(), [&]( const witness_object* a, const witness_object* b )
    {
       return a->props.account_creation_fee.amount < b->props.account_creation_fee.amount;
    } );
-   asset median_account_creation_fee = active[active.size()/2]->props.account_creation_fee;
+   asset median_account_creation_fee = (*median)->props.account_creation_fee;
 
-   /// sort them by maximum_block_size
-   std::sort( active.begin(), active.end(), [&]( const witness_object* a, const witness_object* b )
+   std::nth_element( active.begin(), median, active.end(), [&]( const witness_object* a, const witness_object* b )
    {
       return a->props.maximum_block_size < b->props.maximum_block_size;
    } );
-   uint32_t median_maximum_block_size = active[active.size()/2]->props.maximum_block_size;
+   uint32_t median_maximum_block_size = (*median)->props.maximum_block_size;
 
-   /// sort them by TSD_interest_rate
-   std::sort( active.begin(), active.end(), [&]( const witness_object* a, const witness_object* b )
+   std::nth_element( active.begin(), median, active.end(), [&]( const witness_object* a, const witness_object* b )
    {
       return a->props.TSD_interest_rate < b->props.TSD_interest_rate;
    } );
-   uint16_t median_TSD_interest_rate = active[active.size()/2]->props.TSD_interest_rate;
+   uint16_t median_TSD_interest_rate = (*median)->props.TSD_interest_rate;
 
    db.modify( wso, [&]( witness_schedule_object& _wso )
    {
@@ -92,7 +92,8 @@ void update_witness_schedule4( database& db )
          continue;
       selected_voted.insert( itr->id );
       active_witnesses.push_back( itr->owner) ;
-      db.modify( *itr, [&]( witness_object& wo ) { wo.schedule = witness_object::top19; } );
+      if( itr->schedule != witness_object::top19 )
+         db.modify( *itr, [&]( witness_object& wo ) { wo.schedule = witness_object::top19; } );
    }
 
    auto num_elected = active_witnesses.size();
@@ -113,7 +114,8 @@ void update_witness_schedule4( database& db )
          {
             selected_miners.insert(mitr->id);
             active_witnesses.push_back(mitr->owner);
-            db.modify( *mitr, [&]( witness_object& wo ) { wo.schedule = witness_object::miner; } );
+            if( mitr->schedule != witness_object::miner )
+               db.modify( *mitr, [&]( witness_object& wo ) { wo.schedule = witness_object::miner; } );
          }
       }
       // Remove processed miner from the queue
@@ -150,7 +152,8 @@ void update_witness_schedule4( database& db )
           && selected_voted.find(sitr->id) == selected_voted.end() )
       {
          active_witnesses.push_back(sitr->owner);
-         db.modify( *sitr, [&]( witness_object& wo ) { wo.schedule = witness_object::timeshare; } );
+         if( sitr->schedule != witness_object::timeshare )
+            db.modify( *sitr, [&]( witness_object& wo ) { wo.schedule = witness_object::timeshare; } );
          ++witness_count;
       }
    }
@@ -193,7 +196,7 @@ void update_witness_schedule4( database& db )
 
       for( uint32_t i = 0; i < wso.num_scheduled_witnesses; i++ )
       {
-         auto witness = db.get_witness( wso.current_shuffled_witnesses[ i ] );
+         const auto& witness = db.get_witness( wso.current_shuffled_witnesses[ i ] );
          if( witness_versions.find( witness.running_version ) == witness_versions.end() )
             witness_versions[ witness.running_version ] = 1;
          else
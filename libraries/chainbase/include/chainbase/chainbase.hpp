@@ -170,6 +170,15 @@ namespace chainbase {
          int32_t& _target;
    };
 
+   /**
+    *  Thrown when an index in the mapped file was created with a different object layout than the executable expects
+    */
+   class layout_mismatch_error : public std::runtime_error
+   {
+      public:
+         explicit layout_mismatch_error( const std::string& what ) : std::runtime_error( what ) {}
+   };
+
    /**
     *  The value_type stored in the multiindex container must have a integer field with the name 'id'.  This will
     *  be the primary key and it will be assigned and managed by generic_index.
@@ -191,7 +200,7 @@ namespace chainbase {
 
          void validate()const {
             if( sizeof(typename MultiIndexType::node_type) != _size_of_value_type || sizeof(*this) != _size_of_this )
-               BOOST_THROW_EXCEPTION( std::runtime_error("content of memory does not match data expected by executable") );
+               BOOST_THROW_EXCEPTION( layout_mismatch_error("content of memory does not match data expected by executable") );
          }
 
          /**
@@ -287,6 +296,11 @@ namespace chainbase {
                int64_t        _revision = 0;
          };
 
+         /** The undo state of the innermost session, or nullptr when no session is active */
+         const undo_state_type* head_undo_state()const {
+            return _stack.empty() ? nullptr : &_stack.back();
+         }
+
          session start_undo_session( bool enabled ) {
             if( enabled ) {
                _stack.emplace_back( _indices.get_allocator() );
@@ -897,12 +911,40 @@ namespace chainbase {
              return *obj;
          }
 
+         /**
+          *  Running totals of the objects created, modified and removed through this database, and of the
+          *  bytes the undo states recorded to restore them. The difference across a span of work is the
+          *  work's footprint. The totals are atomic as independent indexes may be written from several
+          *  threads at once, get_change_counters() returns a snapshot.
+          */
+         struct change_counters
+         {
+            uint64_t created = 0;
+            uint64_t modified = 0;
+            uint64_t removed = 0;
+            uint64_t undo_bytes = 0;
+         };
+
+         change_counters get_change_counters()const
+         {
+            change_counters result;
+            result.created = _created.load( std::memory_order_relaxed );
+            result.modified = _modified.load( std::memory_order_relaxed );
+            result.removed = _removed.load( std::memory_order_relaxed );
+            result.undo_bytes = _undo_bytes.load( std::memory_order_relaxed );
+            return result;
+         }
+
          template<typename ObjectType, typename Modifier>
          void modify( const ObjectType& obj, Modifier&& m )
          {
              CHAINBASE_REQUIRE_WRITE_LOCK("modify", ObjectType);
              typedef typename get_index_type<ObjectType>::type index_type;
-             get_mutable_index<index_type>().modify( obj, m );
+             auto& idx = get_mutable_index<index_type>();
+             auto undo_values = undo_value_count( idx );
+             idx.modify( obj, m );
+             _modified.fetch_add( 1, std::memory_order_relaxed );
+             _undo_bytes.fetch_add( ( undo_value_count( idx ) - undo_values ) * sizeof( ObjectType ), std::memory_order_relaxed );
          }
 
          template<typename ObjectType>
@@ -910,7 +952,11 @@ namespace chainbase {
          {
              CHAINBASE_REQUIRE_WRITE_LOCK("remove", ObjectType);
              typedef typename get_index_type<ObjectType>::type index_type;
-             return get_mutable_index<index_type>().remove( obj );
+             auto& idx = get_mutable_index<index_type>();
+             auto undo_values = undo_value_count( idx );
+             idx.remove( obj );
+             _removed.fetch_add( 1, std::memory_order_relaxed );
+             _undo_bytes.fetch_add( ( undo_value_count( idx ) - undo_values ) * sizeof( ObjectType ), std::memory_order_relaxed );
          }
 
          template<typename ObjectType, typename Constructor>
@@ -918,7 +964,12 @@ namespace chainbase {
          {
              CHAINBASE_REQUIRE_WRITE_LOCK("create", ObjectType);
              typedef typename get_index_type<ObjectType>::type index_type;
-             return get_mutable_index<index_type>().emplace( std::forward<Constructor>(con) );
+             auto& idx = get_mutable_index<index_type>();
+             const auto& result = idx.emplace( std::forward<Constructor>(con) );
+             _created.fetch_add( 1, std::memory_order_relaxed );
+             if( idx.head_undo_state() )
+                _undo_bytes.fetch_add( sizeof( typename ObjectType::id_type ), std::memory_order_relaxed );
+             return result;
          }
 
          template< typename Lambda >
@@ -988,6 +1039,14 @@ namespace chainbase {
          }
 
       private:
+         /** Object copies held by the innermost undo state of idx, modify and remove add at most one */
+         template<typename IndexType>
+         static size_t undo_value_count( const IndexType& idx )
+         {
+            auto state = idx.head_undo_state();
+            return state ? state->old_values.size() + state->removed_values.size() : 0;
+         }
+
          unique_ptr<bip::managed_mapped_file>                        _segment;
          unique_ptr<bip::managed_mapped_file>                        _meta;
          read_write_mutex_manager*                                   _rw_manager = nullptr;
@@ -1009,6 +1068,10 @@ namespace chainbase {
          int32_t                                                     _read_lock_count = 0;
          int32_t                                                     _write_lock_count = 0;
          bool                                                        _enable_require_locking = false;
+         std::atomic< uint64_t >                                     _created{ 0 };
+         std::atomic< uint64_t >                                     _modified{ 0 };
+         std::atomic< uint64_t >                                     _removed{ 0 };
+         std::atomic< uint64_t >                                     _undo_bytes{ 0 };
    };
 
    template<typename Object, typename... Args>
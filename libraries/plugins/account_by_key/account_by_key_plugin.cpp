@@ -256,8 +256,18 @@ void account_by_key_plugin::plugin_initialize( const boost::program_options::var
       ilog( "Initializing account_by_key plugin" );
       chain::database& db = database();
 
-      db.pre_apply_operation.connect( [&]( const operation_notification& o ){ my->pre_operation( o ); } );
-      db.post_apply_operation.connect( [&]( const operation_notification& o ){ my->post_operation( o ); } );
+      for( auto op_tag : { operation::tag< accountCreate_operation >::value,
+                           operation::tag< accountCreateWithDelegation_operation >::value,
+                           operation::tag< accountUpdate_operation >::value,
+                           operation::tag< recover_account_operation >::value,
+                           operation::tag< pow_operation >::value,
+                           operation::tag< pow2_operation >::value } )
+      {
+         db.subscribe_operation( op_tag, [&]( const operation_notification& o ){ my->pre_operation( o ); }, true );
+         db.subscribe_operation( op_tag, [&]( const operation_notification& o ){ my->post_operation( o ); }, false );
+      }
+
+      db.subscribe_operation( operation::tag< hardfork_operation >::value, [&]( const operation_notification& o ){ my->post_operation( o ); }, false );
 
       add_plugin_index< key_lookup_index >(db);
    }
@@ -74,7 +74,7 @@ struct operation_visitor
                obj.trx_in_block = _note.trx_in_block;
                obj.op_in_trx    = _note.op_in_trx;
                obj.virtual_op   = _note.virtual_op;
-               obj.timestamp    = _db.head_block_time();
+               obj.timestamp    = _note.timestamp;
                //fc::raw::pack( obj.serialized_op , _note.op);  //call to 'pack' is ambiguous
                auto size = fc::raw::pack_size( _note.op );
                obj.serialized_op.resize( size );
@@ -204,7 +204,8 @@ void account_history_plugin::plugin_set_program_options(
 void account_history_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 {
    //ilog("Intializing account history plugin" );
-   database().pre_apply_operation.connect( [&]( const operation_notification& note ){ my->on_operation(note); } );
+   // History only depends on the operation itself, so it may be built in bulk during reindex
+   database().add_deferrable_operation_handler( [&]( const operation_notification& note ){ my->on_operation(note); }, true );
 
    typedef pair<account_name_type,account_name_type> pairstring;
    LOAD_VALUE_SET(options, "track-account-range", my->_tracked_accounts, pairstring);
@@ -24,7 +24,8 @@ class blockchain_statistics_plugin_impl
       virtual ~blockchain_statistics_plugin_impl() {}
 
       void on_block( const signed_block& b );
-      void pre_operation( const operation_notification& o );
+      void pre_deleteComment( const deleteComment_operation& op );
+      void pre_withdrawSCORE( const withdrawSCORE_operation& op );
       void post_operation( const operation_notification& o );
 
       blockchain_statistics_plugin&       _self;
@@ -331,50 +332,51 @@ void blockchain_statistics_plugin_impl::on_block( const signed_block& b )
    }
 }
 
-void blockchain_statistics_plugin_impl::pre_operation( const operation_notification& o )
+void blockchain_statistics_plugin_impl::pre_deleteComment( const deleteComment_operation& op )
 {
    auto& db = _self.database();
 
    for( auto bucket_id : _current_buckets )
    {
-      if( o.op.which() == operation::tag< deleteComment_operation >::value )
-      {
-         deleteComment_operation op = o.op.get< deleteComment_operation >();
-         auto comment = db.get_comment( op.author, op.permlink );
-         const auto& bucket = db.get(bucket_id);
+      auto comment = db.get_comment( op.author, op.permlink );
+      const auto& bucket = db.get(bucket_id);
 
-         db.modify( bucket, [&]( bucket_object& b )
-         {
-            if( comment.parent_author.length() )
-               b.replies_deleted++;
-            else
-               b.root_comments_deleted++;
-         });
-      }
-      else if( o.op.which() == operation::tag< withdrawSCORE_operation >::value )
+      db.modify( bucket, [&]( bucket_object& b )
       {
-         withdrawSCORE_operation op = o.op.get< withdrawSCORE_operation >();
-         auto& account = db.get_account( op.account );
-         const auto& bucket = db.get(bucket_id);
+         if( comment.parent_author.length() )
+            b.replies_deleted++;
+         else
+            b.root_comments_deleted++;
+      });
+   }
+}
+
+void blockchain_statistics_plugin_impl::pre_withdrawSCORE( const withdrawSCORE_operation& op )
+{
+   auto& db = _self.database();
 
-         auto newSCORE_withdrawal_rate = op.SCORE.amount / TME_fund_for_SCORE_WITHDRAW_INTERVALS;
-         if( op.SCORE.amount > 0 && newSCORE_withdrawal_rate == 0 )
-            newSCORE_withdrawal_rate = 1;
+   for( auto bucket_id : _current_buckets )
+   {
+      auto& account = db.get_account( op.account );
+      const auto& bucket = db.get(bucket_id);
 
-         if( !db.has_hardfork( HARDFORK_0_1 ) )
-            newSCORE_withdrawal_rate *= 1000000;
+      auto newSCORE_withdrawal_rate = op.SCORE.amount / TME_fund_for_SCORE_WITHDRAW_INTERVALS;
+      if( op.SCORE.amount > 0 && newSCORE_withdrawal_rate == 0 )
+         newSCORE_withdrawal_rate = 1;
 
-         db.modify( bucket, [&]( bucket_object& b )
-         {
-            if( account.SCOREwithdrawRateInTME.amount > 0 )
-               b.modified_SCORE_TME_fund_withdrawal_requests++;
-            else
-               b.new_SCORE_TME_fund_withdrawal_requests++;
+      if( !db.has_hardfork( HARDFORK_0_1 ) )
+         newSCORE_withdrawal_rate *= 1000000;
 
-            // TODO: Figure out how to change delta when a SCORE TME fund withdraw finishes. Have until March 24th 2018 to figure that out...
-            b.SCOREwithdrawRateInTME_delta += newSCORE_withdrawal_rate - account.SCOREwithdrawRateInTME.amount;
-         });
-      }
+      db.modify( bucket, [&]( bucket_object& b )
+      {
+         if( account.SCOREwithdrawRateInTME.amount > 0 )
+            b.modified_SCORE_TME_fund_withdrawal_requests++;
+         else
+            b.new_SCORE_TME_fund_withdrawal_requests++;
+
+         // TODO: Figure out how to change delta when a SCORE TME fund withdraw finishes. Have until March 24th 2018 to figure that out...
+         b.SCOREwithdrawRateInTME_delta += newSCORE_withdrawal_rate - account.SCOREwithdrawRateInTME.amount;
+      });
    }
 }
 
@@ -429,8 +431,27 @@ void blockchain_statistics_plugin::plugin_initialize( const boost::program_optio
       chain::database& db = database();
 
       db.applied_block.connect( [&]( const signed_block& b ){ _my->on_block( b ); } );
-      db.pre_apply_operation.connect( [&]( const operation_notification& o ){ _my->pre_operation( o ); } );
-      db.post_apply_operation.connect( [&]( const operation_notification& o ){ _my->post_operation( o ); } );
+      db.subscribe< deleteComment_operation >( [&]( const deleteComment_operation& op, const operation_notification& ){ _my->pre_deleteComment( op ); }, true );
+      db.subscribe< withdrawSCORE_operation >( [&]( const withdrawSCORE_operation& op, const operation_notification& ){ _my->pre_withdrawSCORE( op ); }, true );
+
+      // Every non virtual operation is counted, virtual operations only when operation_process handles them
+      const flat_set< int64_t > counted_virtual_ops = {
+         operation::tag< interest_operation >::value,
+         operation::tag< authorReward_operation >::value,
+         operation::tag< curationReward_operation >::value,
+         operation::tag< liquidity_reward_operation >::value,
+         operation::tag< fillSCOREWithdraw_operation >::value,
+         operation::tag< fill_order_operation >::value,
+         operation::tag< fill_convert_request_operation >::value };
+
+      for( int64_t op_tag = 0; op_tag < operation::count(); ++op_tag )
+      {
+         operation op;
+         op.set_which( op_tag );
+
+         if( !is_virtual_operation( op ) || counted_virtual_ops.count( op_tag ) )
+            db.subscribe_operation( op_tag, [&]( const operation_notification& o ){ _my->post_operation( o ); }, false );
+      }
 
       add_plugin_index< bucket_index >(db);
 
@@ -59,6 +59,9 @@ class debug_node_api_impl
       void debug_set_hardfork( uint32_t hardfork_id );
       bool debug_has_hardfork( uint32_t hardfork_id );
       void debug_get_json_schema( std::string& schema );
+      node::chain::block_timer::timing_stats debug_get_block_timings();
+      std::vector< node::chain::operation_profiler::operation_stats > debug_get_operation_stats();
+      void debug_reset_operation_stats();
       void debug_set_dev_key_prefix( std::string prefix );
       void debug_mine( debug_mine_result& result, const debug_mine_args& args );
       void debug_get_dev_key( get_dev_key_result& result, const get_dev_key_args& args );
@@ -313,6 +316,21 @@ void debug_node_api_impl::debug_get_json_schema( std::string& schema )
    schema = app.chain_database()->get_json_schema();
 }
 
+node::chain::block_timer::timing_stats debug_node_api_impl::debug_get_block_timings()
+{
+   return app.chain_database()->get_block_timer().get_stats();
+}
+
+std::vector< node::chain::operation_profiler::operation_stats > debug_node_api_impl::debug_get_operation_stats()
+{
+   return app.chain_database()->get_operation_profiler().get_stats();
+}
+
+void debug_node_api_impl::debug_reset_operation_stats()
+{
+   app.chain_database()->get_operation_profiler().reset();
+}
+
 } // detail
 
 debug_node_api::debug_node_api( const node::app::api_context& ctx )
@@ -426,4 +444,19 @@ std::string debug_node_api::debug_get_json_schema()
    return result;
 }
 
+node::chain::block_timer::timing_stats debug_node_api::debug_get_block_timings()
+{
+   return my->debug_get_block_timings();
+}
+
+std::vector< node::chain::operation_profiler::operation_stats > debug_node_api::debug_get_operation_stats()
+{
+   return my->debug_get_operation_stats();
+}
+
+void debug_node_api::debug_reset_operation_stats()
+{
+   my->debug_reset_operation_stats();
+}
+
 } } } // node::plugin::debug_node
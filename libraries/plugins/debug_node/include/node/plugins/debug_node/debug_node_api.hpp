@@ -11,6 +11,8 @@
 #include <node/protocol/block.hpp>
 
 #include <node/chain/witness_objects.hpp>
+#include <node/chain/block_timer.hpp>
+#include <node/chain/operation_profiler.hpp>
 
 namespace node { namespace app {
    struct api_context;
@@ -135,6 +137,21 @@ class debug_node_api
 
       std::string debug_get_json_schema();
 
+      /**
+       * Percentiles of the time spent in each stage of applying recent blocks, and the breakdown of the last slow block.
+       */
+      node::chain::block_timer::timing_stats debug_get_block_timings();
+
+      /**
+       * Evaluator counts, times and object changes of each operation type, most total time first.
+       */
+      std::vector< node::chain::operation_profiler::operation_stats > debug_get_operation_stats();
+
+      /**
+       * Restart the operation stats from zero.
+       */
+      void debug_reset_operation_stats();
+
       std::shared_ptr< detail::debug_node_api_impl > my;
 };
 
@@ -173,6 +190,9 @@ FC_API(node::plugin::debug_node::debug_node_api,
        (debug_get_witness_schedule)
        (debug_get_hardfork_property_object)
        (debug_get_json_schema)
+       (debug_get_block_timings)
+       (debug_get_operation_stats)
+       (debug_reset_operation_stats)
        (debug_set_dev_key_prefix)
        (debug_get_dev_key)
        (debug_mine)
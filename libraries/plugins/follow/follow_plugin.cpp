@@ -361,8 +361,18 @@ void follow_plugin::plugin_initialize( const boost::program_options::variables_m
       chain::database& db = database();
       my->plugin_initialize();
 
-      db.pre_apply_operation.connect( [&]( const operation_notification& o ){ my->pre_operation( o ); } );
-      db.post_apply_operation.connect( [&]( const operation_notification& o ){ my->post_operation( o ); } );
+      for( auto op_tag : { operation::tag< vote_operation >::value,
+                           operation::tag< deleteComment_operation >::value } )
+      {
+         db.subscribe_operation( op_tag, [&]( const operation_notification& o ){ my->pre_operation( o ); }, true );
+      }
+
+      for( auto op_tag : { operation::tag< customJson_operation >::value,
+                           operation::tag< comment_operation >::value,
+                           operation::tag< vote_operation >::value } )
+      {
+         db.subscribe_operation( op_tag, [&]( const operation_notification& o ){ my->post_operation( o ); }, false );
+      }
       add_plugin_index< follow_index       >(db);
       add_plugin_index< feed_index         >(db);
       add_plugin_index< blog_index         >(db);
@@ -39,7 +39,7 @@ void market_history_plugin_impl::update_market_histories( const operation_notifi
 
       db.create< order_history_object >( [&]( order_history_object& ho )
       {
-         ho.time = db.head_block_time();
+         ho.time = o.timestamp;
          ho.op = op;
       });
 
@@ -48,9 +48,9 @@ void market_history_plugin_impl::update_market_histories( const operation_notifi
 
       for( auto bucket : _tracked_buckets )
       {
-         auto cutoff = db.head_block_time() - fc::seconds( bucket * _maximum_history_per_bucket_size );
+         auto cutoff = o.timestamp - fc::seconds( bucket * _maximum_history_per_bucket_size );
 
-         auto open = fc::time_point_sec( ( db.head_block_time().sec_since_epoch() / bucket ) * bucket );
+         auto open = fc::time_point_sec( ( o.timestamp.sec_since_epoch() / bucket ) * bucket );
          auto seconds = bucket;
 
          auto itr = bucket_idx.find( boost::make_tuple( seconds, open ) );
@@ -177,7 +177,7 @@ void market_history_plugin::plugin_initialize( const boost::program_options::var
       ilog( "market_history: plugin_initialize() begin" );
       chain::database& db = database();
 
-      db.post_apply_operation.connect( [&]( const operation_notification& o ){ _my->update_market_histories( o ); } );
+      db.add_deferrable_operation_handler( [&]( const operation_notification& o ){ _my->update_market_histories( o ); }, false );
       add_plugin_index< bucket_index        >(db);
       add_plugin_index< order_history_index >(db);
 
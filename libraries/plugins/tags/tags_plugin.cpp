@@ -523,7 +523,15 @@ void tags_plugin::plugin_set_program_options(
 void tags_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 {
    ilog("Intializing tags plugin" );
-   database().post_apply_operation.connect( [&]( const operation_notification& note){ my->on_operation(note); } );
+   for( auto op_tag : { operation::tag< comment_operation >::value,
+                        operation::tag< transfer_operation >::value,
+                        operation::tag< vote_operation >::value,
+                        operation::tag< deleteComment_operation >::value,
+                        operation::tag< comment_reward_operation >::value,
+                        operation::tag< comment_payout_update_operation >::value } )
+   {
+      database().subscribe_operation( op_tag, [&]( const operation_notification& note ){ my->on_operation( note ); }, false );
+   }
 
    app().register_api_factory<tag_api>("tag_api");
 }
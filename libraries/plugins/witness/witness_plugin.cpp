@@ -559,10 +559,25 @@ void witness_plugin::plugin_initialize(const boost::program_options::variables_m
 
    chain::database& db = database();
 
-   db.post_apply_operation.connect( [&]( const operation_notification& note ){ _my->post_operation( note ); } );
+   for( auto op_tag : { operation::tag< custom_operation >::value,
+                        operation::tag< customJson_operation >::value,
+                        operation::tag< custom_binary_operation >::value } )
+   {
+      db.subscribe_operation( op_tag, [&]( const operation_notification& note ){ _my->post_operation( note ); }, false );
+   }
+
    db.pre_apply_block.connect( [&]( const signed_block& b ){ _my->pre_apply_block( b ); } );
    db.on_pre_apply_transaction.connect( [&]( const signed_transaction& tx ){ _my->pre_transaction( tx ); } );
-   db.pre_apply_operation.connect( [&]( const operation_notification& note ){ _my->pre_operation( note ); } );
+
+   for( auto op_tag : { operation::tag< comment_options_operation >::value,
+                        operation::tag< comment_operation >::value,
+                        operation::tag< transfer_operation >::value,
+                        operation::tag< transferToSavings_operation >::value,
+                        operation::tag< transferFromSavings_operation >::value } )
+   {
+      db.subscribe_operation( op_tag, [&]( const operation_notification& note ){ _my->pre_operation( note ); }, true );
+   }
+
    db.applied_block.connect( [&]( const signed_block& b ){ _my->on_block( b ); } );
 
    add_plugin_index< account_bandwidth_index >( db );
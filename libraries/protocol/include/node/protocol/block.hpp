@@ -7,6 +7,12 @@ namespace node { namespace protocol {
    struct signed_block : public signed_block_header
    {
       checksum_type calculate_merkle_root()const;
+
+      /**
+       *  The merkle root of a list of transaction merkle digests, for callers that already have them.
+       */
+      static checksum_type calculate_merkle_root( vector< digest_type > ids );
+
       vector<signed_transaction> transactions;
    };
 
@@ -73,6 +73,16 @@ namespace node { namespace protocol {
          const authority_getter& get_posting,
          uint32_t max_recursion = MAX_SIG_CHECK_DEPTH )const;
 
+      /**
+       * Verifies authority against signature keys that have already been recovered with get_signature_keys().
+       */
+      void verify_authority(
+         const flat_set<public_key_type>& signature_keys,
+         const authority_getter& get_active,
+         const authority_getter& get_owner,
+         const authority_getter& get_posting,
+         uint32_t max_recursion = MAX_SIG_CHECK_DEPTH )const;
+
       set<public_key_type> minimize_required_signatures(
          const chain_id_type& chain_id,
          const flat_set<public_key_type>& available_keys,
@@ -84,6 +94,11 @@ namespace node { namespace protocol {
 
       flat_set<public_key_type> get_signature_keys( const chain_id_type& chain_id )const;
 
+      /**
+       * Recovers the signature keys given a precomputed sig_digest( chain_id ).
+       */
+      flat_set<public_key_type> get_signature_keys_for_digest( const digest_type& sig_digest )const;
+
       vector<signature_type> signatures;
 
       digest_type merkle_digest()const;
@@ -174,7 +174,11 @@ void verify_authority( const vector<operation>& ops, const flat_set<public_key_t
 
 flat_set<public_key_type> signed_transaction::get_signature_keys( const chain_id_type& chain_id )const
 { try {
-   auto d = sig_digest( chain_id );
+   return get_signature_keys_for_digest( sig_digest( chain_id ) );
+} FC_CAPTURE_AND_RETHROW() }
+
+flat_set<public_key_type> signed_transaction::get_signature_keys_for_digest( const digest_type& d )const
+{ try {
    flat_set<public_key_type> result;
    for( const auto&  sig : signatures )
    {
@@ -284,4 +288,14 @@ void signed_transaction::verify_authority(
    node::protocol::verify_authority( operations, get_signature_keys( chain_id ), get_active, get_owner, get_posting, max_recursion );
 } FC_CAPTURE_AND_RETHROW( (*this) ) }
 
+void signed_transaction::verify_authority(
+   const flat_set<public_key_type>& signature_keys,
+   const authority_getter& get_active,
+   const authority_getter& get_owner,
+   const authority_getter& get_posting,
+   uint32_t max_recursion )const
+{ try {
+   node::protocol::verify_authority( operations, signature_keys, get_active, get_owner, get_posting, max_recursion );
+} FC_CAPTURE_AND_RETHROW( (*this) ) }
+
 } } // node::protocol
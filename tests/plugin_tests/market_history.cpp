@@ -3,10 +3,13 @@
 
 #include <node/chain/account_object.hpp>
 #include <node/chain/comment_object.hpp>
+#include <node/chain/history_object.hpp>
 #include <node/protocol/node_operations.hpp>
 
 #include <node/market_history/market_history_plugin.hpp>
 
+#include <graphene/utilities/tempdir.hpp>
+
 #include "../common/database_fixture.hpp"
 
 using namespace node::chain;
@@ -328,5 +331,67 @@ BOOST_AUTO_TEST_CASE( mh_test )
    FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( deferred_notification_replay )
+{
+   using namespace node::market_history;
+
+   try
+   {
+      auto mh_plugin = app.register_plugin< market_history_plugin >();
+      boost::program_options::variables_map options;
+      mh_plugin->plugin_initialize( options );
+
+      // Reindex opens with no initial supply, so the replayed chain is built the same way
+      fc::temp_directory block_dir( graphene::utilities::temp_directory_path() );
+      {
+         database src;
+         src._log_hardforks = false;
+         src.open( block_dir.path(), block_dir.path(), 0, 1024 * 1024 * 8, chainbase::database::read_write );
+         for( uint32_t i = 0; i < 120; ++i )
+            src.generate_block( src.get_slot_time(1), src.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing );
+         src.close();
+      }
+
+      auto plugin_state = [&]()
+      {
+         vector< string > state;
+         for( const auto& o : db.get_index< operation_index >().indices() )
+            state.push_back( fc::json::to_string( o ) );
+         for( const auto& o : db.get_index< account_history_index >().indices() )
+            state.push_back( fc::json::to_string( o ) );
+         for( const auto& o : db.get_index< bucket_index >().indices() )
+            state.push_back( fc::json::to_string( o ) );
+         for( const auto& o : db.get_index< order_history_index >().indices() )
+            state.push_back( fc::json::to_string( o ) );
+         return state;
+      };
+
+      BOOST_TEST_MESSAGE( "--- Replay with operation notifications delivered as each block is applied" );
+      fc::temp_directory inline_dir( graphene::utilities::temp_directory_path() );
+      db.set_deferred_notification_blocks( 0 );
+      db.reindex( block_dir.path(), inline_dir.path(), 1024 * 1024 * 8 );
+      BOOST_REQUIRE_EQUAL( db.head_block_num(), 120 );
+      auto inline_state = plugin_state();
+      BOOST_REQUIRE( db.get_index< operation_index >().indices().size() > 0 );
+      BOOST_REQUIRE( db.get_index< account_history_index >().indices().size() > 0 );
+
+      BOOST_TEST_MESSAGE( "--- Replay with operation notifications deferred and delivered in batches" );
+      fc::temp_directory deferred_dir( graphene::utilities::temp_directory_path() );
+      db.set_deferred_notification_blocks( 16 );
+      db.reindex( block_dir.path(), deferred_dir.path(), 1024 * 1024 * 8 );
+      BOOST_REQUIRE_EQUAL( db.head_block_num(), 120 );
+      auto deferred_state = plugin_state();
+
+      BOOST_REQUIRE_EQUAL( inline_state.size(), deferred_state.size() );
+      for( size_t i = 0; i < inline_state.size(); i++ )
+         BOOST_REQUIRE_EQUAL( inline_state[i], deferred_state[i] );
+
+      // The replayed state lives in the temporary directories, close it before they are removed
+      db.set_deferred_notification_blocks( 0 );
+      db.close();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 #endif
\ No newline at end of file
@@ -28,6 +28,7 @@
 #include <node/protocol/protocol.hpp>
 
 #include <node/protocol/node_operations.hpp>
+#include <node/protocol/exceptions.hpp>
 
 #include <fc/crypto/digest.hpp>
 #include <fc/crypto/hex.hpp>
@@ -324,4 +325,77 @@ BOOST_AUTO_TEST_CASE( merkle_root )
    BOOST_CHECK( block.calculate_merkle_root() == c(dO) );
 }
 
+BOOST_AUTO_TEST_CASE( signature_cache_test )
+{
+   signature_cache cache( 2 );
+   auto alice_key = generate_private_key( "alice" );
+   auto bob_key = generate_private_key( "bob" );
+   const chain_id_type& chain_id = db.get_chain_id();
+
+   signed_transaction tx;
+   tx.set_expiration( fc::time_point_sec( 100 ) );
+   transfer_operation op;
+   op.from = "alice";
+   op.to = "bob";
+   op.amount = asset( 1, SYMBOL_COIN );
+   tx.operations.push_back( op );
+   tx.sign( alice_key, chain_id );
+
+   auto keys = cache.get_signature_keys( tx, chain_id );
+   BOOST_REQUIRE( keys == tx.get_signature_keys( chain_id ) );
+   BOOST_REQUIRE( cache.get_signature_keys( tx, chain_id ) == keys );
+   BOOST_REQUIRE_EQUAL( cache.get_stats().hits, 1 );
+   BOOST_REQUIRE_EQUAL( cache.get_stats().misses, 1 );
+
+   BOOST_TEST_MESSAGE( "Same transaction with different signatures is a separate entry" );
+   signed_transaction tx2 = tx;
+   tx2.signatures.clear();
+   tx2.sign( bob_key, chain_id );
+   BOOST_REQUIRE( *cache.get_signature_keys( tx2, chain_id ).begin() == public_key_type( bob_key.get_public_key() ) );
+   BOOST_REQUIRE_EQUAL( cache.get_stats().misses, 2 );
+
+   BOOST_TEST_MESSAGE( "Cache is bounded and evicts the earliest expiring entry" );
+   signed_transaction tx3 = tx;
+   tx3.set_expiration( fc::time_point_sec( 200 ) );
+   tx3.signatures.clear();
+   tx3.sign( alice_key, chain_id );
+   cache.get_signature_keys( tx3, chain_id );
+   BOOST_REQUIRE_EQUAL( cache.get_stats().size, 2 );
+   BOOST_REQUIRE_EQUAL( cache.get_stats().evictions, 1 );
+
+   BOOST_TEST_MESSAGE( "Expired entries are removed" );
+   cache.remove_expired( fc::time_point_sec( 150 ) );
+   BOOST_REQUIRE_EQUAL( cache.get_stats().size, 1 );
+
+   BOOST_TEST_MESSAGE( "Duplicate signatures are not cached" );
+   tx3.sign( alice_key, chain_id );
+   BOOST_REQUIRE_THROW( cache.get_signature_keys( tx3, chain_id ), tx_duplicate_sig );
+   BOOST_REQUIRE_EQUAL( cache.get_stats().size, 1 );
+}
+
+BOOST_AUTO_TEST_CASE( prepared_transaction_test )
+{
+   auto alice_key = generate_private_key( "alice" );
+   const chain_id_type& chain_id = db.get_chain_id();
+
+   signed_transaction tx;
+   tx.set_expiration( fc::time_point_sec( 100 ) );
+   transfer_operation op;
+   op.from = "alice";
+   op.to = "bob";
+   op.amount = asset( 1, SYMBOL_COIN );
+   op.memo = "memo";
+   tx.operations.push_back( op );
+   tx.sign( alice_key, chain_id );
+   tx.sign( generate_private_key( "bob" ), chain_id );
+
+   prepared_transaction ptx( tx, chain_id );
+   BOOST_REQUIRE( ptx.id() == tx.id() );
+   BOOST_REQUIRE( ptx.sig_digest() == tx.sig_digest( chain_id ) );
+   BOOST_REQUIRE( ptx.merkle_digest() == tx.merkle_digest() );
+   BOOST_REQUIRE( ptx.packed() == fc::raw::pack( tx ) );
+   BOOST_REQUIRE_EQUAL( ptx.packed_size(), fc::raw::pack_size( tx ) );
+   BOOST_REQUIRE( tx.get_signature_keys_for_digest( ptx.sig_digest() ) == tx.get_signature_keys( chain_id ) );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -780,6 +780,17 @@ BOOST_FIXTURE_TEST_CASE( hardfork_test, database_fixture )
       BOOST_REQUIRE( db.has_hardfork( HARDFORK_0_1 ) );
       BOOST_REQUIRE( get_last_operations( 1 )[0].get< custom_operation >().data == vector< char >( op_msg.begin(), op_msg.end() ) );
       BOOST_REQUIRE( db.get(itr->op).timestamp == db.head_block_time() - BLOCK_INTERVAL );
+
+      BOOST_TEST_MESSAGE( "Testing hardfork is undone with the block that applied it" );
+      db.pop_block();
+      db.pop_block();
+
+      BOOST_REQUIRE( db.has_hardfork( 0 ) );
+      BOOST_REQUIRE( !db.has_hardfork( HARDFORK_0_1 ) );
+
+      generate_block();
+
+      BOOST_REQUIRE( db.has_hardfork( HARDFORK_0_1 ) );
    }
    FC_LOG_AND_RETHROW()
 }
@@ -837,5 +848,516 @@ BOOST_FIXTURE_TEST_CASE( generate_block_size, clean_database_fixture )
    FC_LOG_AND_RETHROW()
 }
 
+BOOST_FIXTURE_TEST_CASE( supply_delta_check, clean_database_fixture )
+{
+   try
+   {
+      ACTORS( (alice) );
+      fund( "alice", 10000 );
+      generate_block();
+
+      BOOST_TEST_MESSAGE( "--- Test that balanced changes pass the supply delta check" );
+      auto session = db.start_undo_session( true );
+      db.validate_supply_delta();
+      db.adjust_balance( db.get_account( "alice" ), ASSET( "1.000 TESTS" ) );
+      db.adjust_supply( ASSET( "1.000 TESTS" ) );
+      db.validate_supply_delta();
+
+      BOOST_TEST_MESSAGE( "--- Test that unbalanced changes fail the supply delta check" );
+      db.adjust_TMEsavingsBalance( db.get_account( "alice" ), ASSET( "1.000 TSD" ) );
+      REQUIRE_THROW( db.validate_supply_delta(), fc::exception );
+      session.undo();
+
+      generate_block();
+      validate_database();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( typed_operation_subscription, clean_database_fixture )
+{
+   try
+   {
+      ACTORS( (alice)(bob) );
+      fund( "alice", 10000 );
+      generate_block();
+
+      uint32_t transfers = 0;
+      uint32_t votes = 0;
+      asset transferred;
+
+      db.subscribe< transfer_operation >( [&]( const transfer_operation& op, const operation_notification& note )
+      {
+         ++transfers;
+         transferred = op.amount;
+      }, false );
+      db.subscribe< vote_operation >( [&]( const vote_operation& op, const operation_notification& note )
+      {
+         ++votes;
+      }, true );
+
+      BOOST_TEST_MESSAGE( "--- Test typed handlers only see their operation type" );
+      transfer( "alice", "bob", 1000 );
+
+      BOOST_REQUIRE_EQUAL( transfers, 1 );
+      BOOST_REQUIRE_EQUAL( votes, 0 );
+      BOOST_REQUIRE( transferred == asset( 1000, SYMBOL_COIN ) );
+      BOOST_REQUIRE( db.has_operation_subscribers( operation::tag< transfer_operation >::value ) );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( transaction_pool_limits, clean_database_fixture )
+{
+   try
+   {
+      ACTORS( (alice)(bob) );
+      fund( "alice", 10000 );
+      fund( "bob", 10000 );
+      generate_block();
+
+      auto& pool = db.get_transaction_pool();
+      pool.set_limits( 3, 64*1024*1024, 2 );
+
+      BOOST_TEST_MESSAGE( "--- Test an account's queue is capped" );
+      transfer( "alice", "bob", 1 );
+      transfer( "alice", "bob", 2 );
+      BOOST_REQUIRE_THROW( transfer( "alice", "bob", 3 ), fc::exception );
+      trx.operations.clear();
+      BOOST_REQUIRE_EQUAL( pool.size(), 2 );
+
+      BOOST_TEST_MESSAGE( "--- Test the pool is capped and rejected transactions are not applied" );
+      transfer( "bob", "alice", 1 );
+      BOOST_REQUIRE_THROW( transfer( "bob", "alice", 2 ), fc::exception );
+      trx.operations.clear();
+      BOOST_REQUIRE_EQUAL( pool.size(), 3 );
+      BOOST_REQUIRE_EQUAL( pool.get_stats().rejected, 2 );
+      BOOST_REQUIRE( db.get_account( "bob" ).balance == asset( 10002, SYMBOL_COIN ) );
+
+      BOOST_TEST_MESSAGE( "--- Test pending transactions are included and leave the pool" );
+      generate_block();
+      BOOST_REQUIRE( pool.empty() );
+      BOOST_REQUIRE_EQUAL( db.fetch_block_by_number( db.head_block_num() )->transactions.size(), 3 );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( generate_block_from_pending_state, clean_database_fixture )
+{
+   try
+   {
+      ACTORS( (alice)(bob) );
+      fund( "alice", 10000 );
+      generate_block();
+
+      BOOST_TEST_MESSAGE( "--- Test pending transactions become the block without a rebuild" );
+      signed_transaction tx;
+      transfer_operation op;
+      op.from = "alice";
+      op.to = "bob";
+      op.amount = asset( 1000, SYMBOL_COIN );
+      tx.operations.push_back( op );
+      tx.set_expiration( db.head_block_time() + MAX_TIME_UNTIL_EXPIRATION );
+      tx.sign( alice_private_key, db.get_chain_id() );
+      db.push_transaction( tx, 0 );
+
+      tx.clear();
+      op.amount = asset( 2000, SYMBOL_COIN );
+      tx.operations.push_back( op );
+      tx.sign( alice_private_key, db.get_chain_id() );
+      db.push_transaction( tx, 0 );
+
+      generate_block();
+      BOOST_REQUIRE_EQUAL( db.fetch_block_by_number( db.head_block_num() )->transactions.size(), 2 );
+      BOOST_REQUIRE( db.get_account( "bob" ).balance == asset( 3000, SYMBOL_COIN ) );
+
+      BOOST_TEST_MESSAGE( "--- Test transactions pushed skipping checks are re-applied" );
+      transfer( "alice", "bob", 500 );
+      generate_block();
+      BOOST_REQUIRE_EQUAL( db.fetch_block_by_number( db.head_block_num() )->transactions.size(), 1 );
+      BOOST_REQUIRE( db.get_account( "bob" ).balance == asset( 3500, SYMBOL_COIN ) );
+      validate_database();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( block_stage_timings, clean_database_fixture )
+{
+   try
+   {
+      ACTORS( (alice)(bob) );
+      fund( "alice", 10000 );
+      generate_block();
+
+      db.get_block_timer().set_window( 3 );
+      db.get_block_timer().set_slow_threshold( fc::microseconds( -1 ) );
+
+      transfer( "alice", "bob", 500 );
+      generate_block();
+
+      auto stats = db.get_block_timer().get_stats();
+      BOOST_REQUIRE_EQUAL( stats.blocks, 3 );
+      BOOST_REQUIRE_EQUAL( stats.stages.size(), block_timer::stage_count + 1 );
+      BOOST_REQUIRE( stats.stages.front().stage == "block" );
+      BOOST_REQUIRE( stats.stages.front().p50 <= stats.stages.front().p99 );
+
+      BOOST_TEST_MESSAGE( "--- Test the slow block report lists the block's operations" );
+      BOOST_REQUIRE( stats.last_slow_block.valid() );
+      BOOST_REQUIRE_EQUAL( stats.last_slow_block->block_num, db.head_block_num() );
+      BOOST_REQUIRE_EQUAL( stats.last_slow_block->transactions, 1 );
+      BOOST_REQUIRE( stats.last_slow_block->stages.size() <= 5 );
+      BOOST_REQUIRE_EQUAL( stats.last_slow_block->operations.size(), 1 );
+      BOOST_REQUIRE( stats.last_slow_block->operations[0].operation == "transfer" );
+      BOOST_REQUIRE_EQUAL( stats.last_slow_block->operations[0].count, 1 );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( operation_profile, clean_database_fixture )
+{
+   try
+   {
+      ACTORS( (alice)(bob) );
+      fund( "alice", 10000 );
+      generate_block();
+
+      db.get_operation_profiler().reset();
+      BOOST_REQUIRE( db.get_operation_profiler().get_stats().empty() );
+
+      transfer( "alice", "bob", 500 );
+      generate_block();
+
+      auto stats = db.get_operation_profiler().get_stats();
+      BOOST_REQUIRE_EQUAL( stats.size(), 1 );
+      BOOST_REQUIRE( stats[0].operation == "transfer" );
+      BOOST_REQUIRE( stats[0].count >= 1 );
+      BOOST_REQUIRE( stats[0].avg_ns == stats[0].total_ns / stats[0].count );
+      BOOST_REQUIRE( stats[0].max_ns <= stats[0].total_ns );
+      BOOST_REQUIRE( stats[0].modified >= 2 * stats[0].count );
+      BOOST_REQUIRE( stats[0].undo_bytes > 0 );
+
+      db.get_operation_profiler().reset();
+      BOOST_REQUIRE( db.get_operation_profiler().get_stats().empty() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( parallel_signature_recovery )
+{
+   try {
+      fc::temp_directory data_dir1( graphene::utilities::temp_directory_path() );
+      fc::temp_directory data_dir2( graphene::utilities::temp_directory_path() );
+
+      database db1;
+      db1._log_hardforks = false;
+      db1.open( data_dir1.path(), data_dir1.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write );
+      database db2;
+      db2._log_hardforks = false;
+      db2.open( data_dir2.path(), data_dir2.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write );
+      db2.set_thread_pool_size( 4 );
+
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("init_key")) );
+      auto b = db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+      PUSH_BLOCK( db2, b );
+
+      for( uint32_t i = 0; i < 10; ++i )
+      {
+         signed_transaction trx;
+         transfer_operation t;
+         t.from = genesisAccountBasename;
+         t.to = TEMP_ACCOUNT;
+         t.amount = asset( i + 1, SYMBOL_COIN );
+         trx.operations.push_back( t );
+         trx.set_expiration( db1.head_block_time() + MAX_TIME_UNTIL_EXPIRATION );
+         trx.sign( init_account_priv_key, db1.get_chain_id() );
+         PUSH_TX( db1, trx, database::skip_nothing );
+      }
+
+      b = db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+      BOOST_REQUIRE_EQUAL( b.transactions.size(), 10 );
+
+      auto prepared = db2.prepare_transactions( b, database::skip_nothing );
+      BOOST_REQUIRE_EQUAL( prepared.size(), 10 );
+      for( const auto& p : prepared )
+      {
+         BOOST_REQUIRE( p.validated );
+         BOOST_REQUIRE( p.signature_keys.valid() );
+         BOOST_REQUIRE( p.signature_keys->size() == 1 );
+         BOOST_REQUIRE( *p.signature_keys->begin() == public_key_type( init_account_priv_key.get_public_key() ) );
+      }
+      BOOST_REQUIRE( db2.calculate_merkle_root( prepared ) == b.transaction_merkle_root );
+
+      BOOST_TEST_MESSAGE( "Verify that a merkle tree large enough to hash on the thread pool has the same root" );
+      vector< digest_type > ids;
+      for( uint32_t i = 0; i < 2501; ++i )
+         ids.push_back( digest_type::hash( i ) );
+      BOOST_REQUIRE( db2.calculate_merkle_root( ids ) == signed_block::calculate_merkle_root( ids ) );
+
+      BOOST_TEST_MESSAGE( "Verify that a block with a bad signature is rejected" );
+      signed_block bad_block = b;
+      bad_block.transactions.back().signatures.clear();
+      bad_block.transactions.back().sign( fc::ecc::private_key::regenerate( fc::sha256::hash( string( "bogus" ) ) ), db1.get_chain_id() );
+      bad_block.transaction_merkle_root = bad_block.calculate_merkle_root();
+      bad_block.sign( init_account_priv_key );
+      CHECK_THROW( PUSH_BLOCK( db2, bad_block ), fc::exception );
+      BOOST_REQUIRE_EQUAL( db2.head_block_num(), 1 );
+
+      PUSH_BLOCK( db2, b );
+      BOOST_REQUIRE( db2.head_block_id() == db1.head_block_id() );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( out_of_order_blocks )
+{
+   try {
+      fc::temp_directory data_dir1( graphene::utilities::temp_directory_path() );
+      fc::temp_directory data_dir2( graphene::utilities::temp_directory_path() );
+
+      database db1;
+      db1._log_hardforks = false;
+      db1.open( data_dir1.path(), data_dir1.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write );
+      database db2;
+      db2._log_hardforks = false;
+      db2.open( data_dir2.path(), data_dir2.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write );
+
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("init_key")) );
+      auto b1 = db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+      PUSH_BLOCK( db2, b1 );
+
+      vector< signed_block > blocks;
+      for( uint32_t i = 0; i < 3; ++i )
+         blocks.push_back( db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing) );
+
+      BOOST_TEST_MESSAGE( "Push blocks ahead of their parent, they are buffered" );
+      CHECK_THROW( PUSH_BLOCK( db2, blocks[2] ), unlinkable_block_exception );
+      CHECK_THROW( PUSH_BLOCK( db2, blocks[1] ), unlinkable_block_exception );
+      BOOST_REQUIRE_EQUAL( db2.head_block_num(), 1 );
+      // Buffered blocks are not linked or validated yet, they are not served as known blocks
+      BOOST_REQUIRE( !db2.is_known_block( blocks[2].id() ) );
+      BOOST_REQUIRE( !db2.fetch_block_by_id( blocks[2].id() ).valid() );
+
+      BOOST_TEST_MESSAGE( "Push the missing parent, the buffered blocks are applied after it" );
+      BOOST_REQUIRE( !PUSH_BLOCK( db2, blocks[0] ) );
+      BOOST_REQUIRE( db2.head_block_id() == db1.head_block_id() );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( unlinked_block_limit )
+{
+   try {
+      fc::temp_directory data_dir1( graphene::utilities::temp_directory_path() );
+      fc::temp_directory data_dir2( graphene::utilities::temp_directory_path() );
+
+      database db1;
+      db1._log_hardforks = false;
+      db1.open( data_dir1.path(), data_dir1.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write );
+      database db2;
+      db2._log_hardforks = false;
+      db2.open( data_dir2.path(), data_dir2.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write );
+      db2.set_max_unlinked_blocks( 2 );
+
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("init_key")) );
+      auto b1 = db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+      PUSH_BLOCK( db2, b1 );
+
+      vector< signed_block > blocks;
+      for( uint32_t i = 0; i < 5; ++i )
+         blocks.push_back( db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing) );
+
+      BOOST_TEST_MESSAGE( "A full buffer ignores blocks further from the head than the ones it holds" );
+      CHECK_THROW( PUSH_BLOCK( db2, blocks[3] ), unlinkable_block_exception );
+      CHECK_THROW( PUSH_BLOCK( db2, blocks[2] ), unlinkable_block_exception );
+      CHECK_THROW( PUSH_BLOCK( db2, blocks[4] ), unlinkable_block_exception );
+
+      BOOST_TEST_MESSAGE( "A closer block replaces the furthest buffered block" );
+      CHECK_THROW( PUSH_BLOCK( db2, blocks[1] ), unlinkable_block_exception );
+      BOOST_REQUIRE( !PUSH_BLOCK( db2, blocks[0] ) );
+      BOOST_REQUIRE( db2.head_block_id() == blocks[2].id() );
+
+      PUSH_BLOCK( db2, blocks[3] );
+      PUSH_BLOCK( db2, blocks[4] );
+      BOOST_REQUIRE( db2.head_block_id() == db1.head_block_id() );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( async_block_log_writes )
+{
+   try {
+      fc::temp_directory data_dir1( graphene::utilities::temp_directory_path() );
+      fc::temp_directory data_dir2( graphene::utilities::temp_directory_path() );
+      auto init_account_priv_key = fc::ecc::private_key::regenerate( fc::sha256::hash( string( "init_key" ) ) );
+
+      auto generate = [&]( database& db )
+      {
+         db.generate_block( db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing );
+      };
+      auto last_irreversible = []( const database& db )
+      {
+         return db.get_dynamic_global_properties().last_irreversible_block_num;
+      };
+
+      map< uint32_t, block_id_type > ids;
+      uint32_t durable = 0;
+      uint32_t lib = 0;
+      {
+         database db;
+         db._log_hardforks = false;
+         db.open( data_dir1.path(), data_dir1.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write );
+
+         while( last_irreversible( db ) < 10 )
+            generate( db );
+         db.flush_block_log();
+         durable = db.get_block_log_durable_num();
+         BOOST_REQUIRE_EQUAL( durable, last_irreversible( db ) );
+
+         BOOST_TEST_MESSAGE( "Irreversible blocks that are not written yet are served from the fork database" );
+         db.pause_block_log_writes( true );
+         while( last_irreversible( db ) < durable + 20 )
+            generate( db );
+         lib = last_irreversible( db );
+         BOOST_REQUIRE_EQUAL( db.get_block_log_durable_num(), durable );
+
+         for( uint32_t n = 1; n <= lib; n++ )
+         {
+            auto b = db.fetch_block_by_number( n );
+            BOOST_REQUIRE( b.valid() );
+            BOOST_REQUIRE_EQUAL( b->block_num(), n );
+            ids[n] = b->id();
+         }
+
+         // Destroyed without close(), as if the node died right after the writer drained
+      }
+      {
+         BOOST_TEST_MESSAGE( "Undo history was only committed up to the durable block" );
+         database db;
+         db._log_hardforks = false;
+         db.open( data_dir1.path(), data_dir1.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write );
+         BOOST_REQUIRE_EQUAL( db.head_block_num(), durable );
+
+         for( uint32_t n = 1; n <= lib; n++ )
+         {
+            auto b = db.fetch_block_by_number( n );
+            BOOST_REQUIRE( b.valid() );
+            BOOST_REQUIRE( b->id() == ids[n] );
+         }
+         db.close();
+      }
+
+      {
+         BOOST_TEST_MESSAGE( "Blocks still queued at close() are written and nothing is lost on reopen" );
+         database db;
+         db._log_hardforks = false;
+         db.open( data_dir2.path(), data_dir2.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write );
+
+         while( last_irreversible( db ) < 10 )
+            generate( db );
+         db.pause_block_log_writes( true );
+         while( last_irreversible( db ) < 30 )
+            generate( db );
+         lib = last_irreversible( db );
+         BOOST_REQUIRE( db.get_block_log_durable_num() < lib );
+
+         ids.clear();
+         for( uint32_t n = 1; n <= lib; n++ )
+            ids[n] = db.fetch_block_by_number( n )->id();
+         db.close();
+
+         db.open( data_dir2.path(), data_dir2.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write );
+         BOOST_REQUIRE_EQUAL( db.head_block_num(), lib );
+         BOOST_REQUIRE_EQUAL( db.get_block_log_durable_num(), lib );
+         for( uint32_t n = 1; n <= lib; n++ )
+         {
+            auto b = db.fetch_block_by_number( n );
+            BOOST_REQUIRE( b.valid() );
+            BOOST_REQUIRE( b->id() == ids[n] );
+         }
+         db.close();
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( resume_checkpointed_reindex )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      auto init_account_priv_key = fc::ecc::private_key::regenerate( fc::sha256::hash( string( "init_key" ) ) );
+      const uint32_t checkpoint_interval = 10;
+      const uint32_t stop_block = 35;
+
+      {
+         database db;
+         db._log_hardforks = false;
+         db.open( data_dir.path(), data_dir.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write );
+         for( uint32_t i = 0; i < 60; ++i )
+            db.generate_block( db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing );
+         db.close();
+      }
+
+      auto state_of = []( const database& db )
+      {
+         return fc::json::to_string( db.get_dynamic_global_properties() ) +
+            fc::json::to_string( db.get_witness_schedule_object() ) +
+            fc::json::to_string( db.get_account( genesisAccountBasename ) );
+      };
+
+      block_id_type expected_head;
+      string expected_state;
+      {
+         database db;
+         db._log_hardforks = false;
+         db.reindex( data_dir.path(), data_dir.path(), TEST_SHARED_MEM_SIZE, 0 );
+         expected_head = db.head_block_id();
+         expected_state = state_of( db );
+         db.close();
+      }
+
+      {
+         BOOST_TEST_MESSAGE( "Stop a checkpointed reindex partway through" );
+         database db;
+         db._log_hardforks = false;
+         db.applied_block.connect( [&]( const signed_block& b )
+         {
+            if( b.block_num() == stop_block )
+               FC_THROW_EXCEPTION( plugin_exception, "Stopping reindex" );
+         });
+         BOOST_REQUIRE_THROW( db.reindex( data_dir.path(), data_dir.path(), TEST_SHARED_MEM_SIZE, checkpoint_interval ), fc::exception );
+         db.close();
+      }
+
+      {
+         BOOST_TEST_MESSAGE( "Reindex again, it resumes from the last checkpoint and ends with the same state" );
+         database db;
+         db._log_hardforks = false;
+         uint32_t first_block = 0;
+         db.applied_block.connect( [&]( const signed_block& b )
+         {
+            if( !first_block )
+               first_block = b.block_num();
+         });
+         db.reindex( data_dir.path(), data_dir.path(), TEST_SHARED_MEM_SIZE, checkpoint_interval );
+
+         BOOST_REQUIRE_EQUAL( first_block, stop_block - stop_block % checkpoint_interval + 1 );
+         BOOST_REQUIRE( db.head_block_id() == expected_head );
+         BOOST_REQUIRE_EQUAL( state_of( db ), expected_state );
+         db.close();
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 #endif
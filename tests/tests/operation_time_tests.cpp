@@ -1505,6 +1505,8 @@ BOOST_AUTO_TEST_CASE( feed_publish_mean )
          feed_history = db.get(feed_history_id_type());
          BOOST_REQUIRE( feed_history.current_median_history == feed_history.price_history[ ( i + 1 ) / 2 ] );
          BOOST_REQUIRE( feed_history.price_history[ i + 1 ] == ops[4].exchange_rate );
+         BOOST_REQUIRE( feed_history.sorted_history.size() == feed_history.price_history.size() );
+         BOOST_REQUIRE( std::is_sorted( feed_history.sorted_history.begin(), feed_history.sorted_history.end() ) );
          validate_database();
       }
    }